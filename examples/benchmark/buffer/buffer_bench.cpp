@@ -0,0 +1,123 @@
+#include "stnl/Buffer.h"
+#include "stnl/BufferPool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace stnl;
+
+/**
+ * 旧版本 NetBuffer 的增长策略：std::vector<char> + resize(writeIndex + len)，
+ * 每次增长都会对新字节做零初始化，并且按需精确增长。作为对照组。
+ */
+class VectorBuffer
+{
+public:
+    VectorBuffer() : buffer_(8 + 1024), readIndex_(8), writeIndex_(8) {}
+
+    void append(const char *buf, size_t len)
+    {
+        if (len > buffer_.size() - writeIndex_)
+        {
+            buffer_.resize(writeIndex_ + len);
+        }
+        std::copy(buf, buf + len, buffer_.data() + writeIndex_);
+        writeIndex_ += len;
+    }
+
+    size_t readableBytes() const { return writeIndex_ - readIndex_; }
+
+    void retrieveAll()
+    {
+        readIndex_ = 8;
+        writeIndex_ = 8;
+    }
+
+private:
+    std::vector<char> buffer_;
+    size_t readIndex_;
+    size_t writeIndex_;
+};
+
+template <typename Buffer, typename MakeBuffer>
+double benchAppend(MakeBuffer makeBuffer, const std::string &data, size_t bytesPerRound, int rounds)
+{
+    size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+    {
+        // 每一轮都使用新的 buffer，模拟新连接上的数据从零开始累积
+        auto buf = makeBuffer();
+        while (buf->readableBytes() < bytesPerRound)
+        {
+            buf->append(data.data(), data.size());
+        }
+        total += buf->readableBytes();
+        buf->retrieveAll();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(total) / seconds / (1024 * 1024);
+}
+
+/**
+ * 使用 ensureWritable/hasWritten 直接在 buffer 中编码，省去一次中间拷贝。
+ */
+double benchEncodeInPlace(size_t messageSize, size_t bytesPerRound, int rounds)
+{
+    size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+    {
+        NetBuffer buf;
+        while (buf.readableBytes() < bytesPerRound)
+        {
+            buf.ensureWritable(messageSize);
+            memset(buf.writeIndex(), 'e', messageSize);
+            buf.hasWritten(messageSize);
+        }
+        total += buf.readableBytes();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(total) / seconds / (1024 * 1024);
+}
+
+void runCase(size_t messageSize, size_t bytesPerRound, int rounds)
+{
+    std::string data(messageSize, 'x');
+    std::shared_ptr<BufferPool> pool = std::make_shared<BufferPool>();
+
+    double vectorMiBs = benchAppend<VectorBuffer>(
+        []() { return std::make_unique<VectorBuffer>(); }, data, bytesPerRound, rounds);
+    double heapMiBs = benchAppend<NetBuffer>(
+        []() { return std::make_unique<NetBuffer>(); }, data, bytesPerRound, rounds);
+    double poolMiBs = benchAppend<NetBuffer>(
+        [&]() { return std::make_unique<NetBuffer>(pool); }, data, bytesPerRound, rounds);
+    double inPlaceMiBs = benchEncodeInPlace(messageSize, bytesPerRound, rounds);
+
+    printf("%8zu B writes, %8zu B/round: vector-resize %9.1f MiB/s | NetBuffer %9.1f MiB/s | "
+           "NetBuffer(pool) %9.1f MiB/s | ensureWritable %9.1f MiB/s\n",
+           messageSize, bytesPerRound, vectorMiBs, heapMiBs, poolMiBs, inPlaceMiBs);
+}
+
+/*
+    ./buffer_bench [rounds]
+*/
+int main(int argc, char *argv[])
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 200;
+
+    // 小块写入
+    runCase(16, 256 * 1024, rounds);
+    runCase(128, 256 * 1024, rounds);
+    runCase(1024, 1024 * 1024, rounds);
+
+    // 大块写入
+    runCase(16 * 1024, 4 * 1024 * 1024, rounds / 4 + 1);
+    runCase(256 * 1024, 16 * 1024 * 1024, rounds / 8 + 1);
+}
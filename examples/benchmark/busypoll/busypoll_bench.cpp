@@ -0,0 +1,190 @@
+#include "stnl/TcpServer.h"
+#include "stnl/TcpClient.h"
+#include "stnl/EventLoop.h"
+#include "stnl/TimeUtil.h"
+#include "stnl/Timer.h"
+#include "stnl/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace stnl;
+using namespace std::placeholders;
+
+/**
+ * 比较 EventLoop 阻塞模式与忙轮询模式下的往返延迟。
+ *
+ * 同一进程中启动一个 echo 服务端和一个客户端，客户端每隔 interval 微秒发送一条 8 字节的消息，
+ * 收到回复后记录往返时间。两条消息之间 loop 处于空闲状态：阻塞模式下两端的线程都会在
+ * epoll_wait 中睡眠，下一条消息到达时需要被内核唤醒；忙轮询模式下 loop 在空闲后仍然持续轮询。
+ *
+ * 注意：忙轮询模式下服务端与客户端各自占满一个 CPU，CPU 核数不足时结果没有意义。
+ */
+
+struct Options
+{
+    int messages = 20000;
+    int intervalUs = 200;       // 两条消息之间的间隔
+    double spinSeconds = 0.005; // 忙轮询时间，应大于 intervalUs
+    int socketBusyPollUs = 0;   // SO_BUSY_POLL，0 表示不设置
+};
+
+void runServer(uint16_t port, double spinSeconds, int socketBusyPollUs)
+{
+    TcpServer server(SockAddr("127.0.0.1", port), "busypoll-server");
+    server.setConnectionCallback([](const TcpConnection::TcpConnectionPtr &conn) {
+        if (conn->isConnected())
+        {
+            conn->setTcpNoDelay(true);
+        }
+    });
+    server.setMessageCallback([](const TcpConnection::TcpConnectionPtr &conn, NetBuffer *buf, Timestamp) {
+        conn->send(buf);
+    });
+    if (spinSeconds > 0.0)
+    {
+        server.setBusyPoll(spinSeconds, socketBusyPollUs);
+    }
+    server.start();
+}
+
+class LatencyClient : public noncopyable
+{
+public:
+    LatencyClient(EventLoop *loop, uint16_t port, const Options &options)
+        : loop_(loop),
+          client_(loop, SockAddr("127.0.0.1", port), "busypoll-client"),
+          options_(options),
+          message_(8, 'x')
+    {
+        rtts_.reserve(options_.messages);
+        client_.setConnectionCallback(std::bind(&LatencyClient::onConnection, this, _1));
+        client_.setMessageCallback(std::bind(&LatencyClient::onMessage, this, _1, _2, _3));
+    }
+
+    void connect() { client_.connect(); }
+
+    std::vector<int64_t> &rtts() { return rtts_; }
+
+private:
+    void onConnection(const TcpConnection::TcpConnectionPtr &conn)
+    {
+        if (conn->isConnected())
+        {
+            conn->setTcpNoDelay(true);
+            conn_ = conn;
+            sendOne();
+        }
+    }
+
+    void onMessage(const TcpConnection::TcpConnectionPtr &, NetBuffer *buf, Timestamp)
+    {
+        if (buf->readableBytes() < message_.size())
+        {
+            return;
+        }
+        buf->retrieve(message_.size());
+
+        auto now = std::chrono::steady_clock::now();
+        rtts_.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(now - sendTime_).count());
+
+        if (static_cast<int>(rtts_.size()) == options_.messages)
+        {
+            client_.disconnect();
+            loop_->queueInLoop(std::bind(&EventLoop::quit, loop_));
+            return;
+        }
+        loop_->runAfter(options_.intervalUs / 1e6, std::bind(&LatencyClient::sendOne, this));
+    }
+
+    void sendOne()
+    {
+        sendTime_ = std::chrono::steady_clock::now();
+        conn_->send(message_);
+    }
+
+    EventLoop *loop_;
+    TcpClient client_;
+    Options options_;
+    std::string message_;
+    TcpConnection::TcpConnectionPtr conn_;
+    std::chrono::steady_clock::time_point sendTime_;
+    std::vector<int64_t> rtts_;
+};
+
+void report(const char *mode, std::vector<int64_t> &rtts)
+{
+    if (rtts.empty())
+    {
+        printf("%-10s no samples\n", mode);
+        return;
+    }
+    std::sort(rtts.begin(), rtts.end());
+    auto percentile = [&rtts](double p) {
+        size_t index = static_cast<size_t>(p * static_cast<double>(rtts.size() - 1));
+        return static_cast<double>(rtts[index]) / 1000.0;
+    };
+    printf("%-10s samples=%zu p50=%.1fus p99=%.1fus p99.9=%.1fus max=%.1fus\n",
+           mode, rtts.size(), percentile(0.5), percentile(0.99), percentile(0.999),
+           static_cast<double>(rtts.back()) / 1000.0);
+}
+
+void runRound(const char *mode, uint16_t port, const Options &options, double spinSeconds)
+{
+    std::thread(runServer, port, spinSeconds, options.socketBusyPollUs).detach();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::vector<int64_t> rtts;
+    std::thread clientThread([&]() {
+        EventLoop loop;
+        loop.setBusyPollDuration(spinSeconds);
+        LatencyClient client(&loop, port, options);
+        client.connect();
+        loop.loop();
+        rtts.swap(client.rtts());
+    });
+    clientThread.join();
+
+    report(mode, rtts);
+}
+
+/*
+    ./busypoll_bench [messages] [interval_us] [spin_us] [so_busy_poll_us]
+    ./busypoll_bench 20000 200 5000 50
+*/
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (argc > 1)
+    {
+        options.messages = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        options.intervalUs = atoi(argv[2]);
+    }
+    if (argc > 3)
+    {
+        options.spinSeconds = atoi(argv[3]) / 1e6;
+    }
+    if (argc > 4)
+    {
+        options.socketBusyPollUs = atoi(argv[4]);
+    }
+
+    printf("messages=%d interval=%dus spin=%.0fus so_busy_poll=%dus cpus=%u\n",
+           options.messages, options.intervalUs, options.spinSeconds * 1e6,
+           options.socketBusyPollUs, std::thread::hardware_concurrency());
+
+    runRound("blocking", 34501, options, 0.0);
+    runRound("spinning", 34502, options, options.spinSeconds);
+
+    // 服务端没有提供停止接口，直接退出进程
+    fflush(stdout);
+    std::quick_exit(0);
+}
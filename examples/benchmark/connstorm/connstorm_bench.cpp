@@ -0,0 +1,211 @@
+#include "stnl/TcpServer.h"
+#include "stnl/EventLoop.h"
+#include "stnl/TimeUtil.h"
+#include "stnl/logger.h"
+
+#include "../latency/Histogram.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace stnl;
+
+/**
+ * 短连接风暴测试：客户端线程不断地建立连接、等待服务端的第一个字节、关闭连接，
+ * 测量 TcpServer 在不同 IO 线程数下的建连速率、首字节时间与连接拆除时间。
+ *
+ * 覆盖服务端的两条路径：
+ *   建立：Acceptor::handleRead -> newConnectionCallback -> connectionEstablish -> ConnectionCallback 发送 1 字节
+ *   拆除：handleRead 读到 0 -> handleClose -> removeConnection -> connectionDestory -> 关闭 socket
+ *
+ * 首字节时间：客户端开始 connect 到读到服务端发送的第一个字节。
+ * 拆除时间：客户端 shutdown(SHUT_WR) 到读到服务端关闭连接产生的 EOF，即上面整条拆除路径。
+ * 之后客户端以 RST 关闭 socket，避免客户端的端口大量处于 TIME_WAIT 状态。
+ */
+
+struct RoundResult
+{
+    int64_t connections = 0;
+    int64_t failures = 0;
+    Histogram connectTime;
+    Histogram firstByteTime;
+    Histogram teardownTime;
+};
+
+namespace
+{
+    std::atomic_int64_t g_established(0);
+
+    int64_t nowNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void runServer(uint16_t port, int threadNums)
+    {
+        TcpServer server(SockAddr("127.0.0.1", port), "connstorm-server", threadNums);
+        server.setConnectionCallback([](const TcpConnection::TcpConnectionPtr &conn) {
+            if (conn->isConnected())
+            {
+                ++g_established;
+                conn->send("x", 1);
+            }
+        });
+        server.start();
+    }
+
+    /**
+     * 完成一次 建立-首字节-拆除，返回是否成功
+     */
+    bool oneConnection(const struct sockaddr_in &addr, RoundResult &result)
+    {
+        int64_t start = nowNanoseconds();
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        // 服务端异常时不要永久阻塞，超时计为失败
+        struct timeval timeout = {1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        bool ok = false;
+        char byte;
+        if (::connect(fd, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr)) == 0)
+        {
+            int64_t connected = nowNanoseconds();
+            if (::read(fd, &byte, 1) == 1)
+            {
+                int64_t firstByte = nowNanoseconds();
+                ::shutdown(fd, SHUT_WR);
+                if (::read(fd, &byte, 1) == 0)
+                {
+                    int64_t closed = nowNanoseconds();
+                    result.connectTime.record(connected - start);
+                    result.firstByteTime.record(firstByte - start);
+                    result.teardownTime.record(closed - firstByte);
+                    ok = true;
+                }
+            }
+        }
+
+        struct linger lingerOption = {1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lingerOption, sizeof(lingerOption));
+        ::close(fd);
+        return ok;
+    }
+
+    void printHistogram(const char *name, const Histogram &histogram)
+    {
+        printf("  %-10s p50=%8.1fus p99=%8.1fus p99.9=%8.1fus max=%8.1fus\n", name,
+               static_cast<double>(histogram.valueAtPercentile(50)) / 1000.0,
+               static_cast<double>(histogram.valueAtPercentile(99)) / 1000.0,
+               static_cast<double>(histogram.valueAtPercentile(99.9)) / 1000.0,
+               static_cast<double>(histogram.max()) / 1000.0);
+    }
+
+    void runRound(uint16_t port, int serverThreads, int clientThreads, double seconds)
+    {
+        std::thread(runServer, port, serverThreads).detach();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        struct sockaddr_in addr;
+        ::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        std::vector<RoundResult> results(clientThreads);
+        std::vector<std::thread> threads;
+        int64_t establishedBefore = g_established;
+        int64_t deadline = nowNanoseconds() + static_cast<int64_t>(seconds * 1e9);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < clientThreads; ++i)
+        {
+            threads.emplace_back([&, i]() {
+                RoundResult &result = results[i];
+                while (nowNanoseconds() < deadline)
+                {
+                    if (oneConnection(addr, result))
+                    {
+                        ++result.connections;
+                    }
+                    else
+                    {
+                        ++result.failures;
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        RoundResult total;
+        for (const auto &result : results)
+        {
+            total.connections += result.connections;
+            total.failures += result.failures;
+            total.connectTime.merge(result.connectTime);
+            total.firstByteTime.merge(result.firstByteTime);
+            total.teardownTime.merge(result.teardownTime);
+        }
+
+        printf("server threads=%d client threads=%d: %.0f conn/s accepted, %lld completed, %lld failed\n",
+               serverThreads, clientThreads,
+               static_cast<double>(g_established - establishedBefore) / elapsed,
+               static_cast<long long>(total.connections), static_cast<long long>(total.failures));
+        printHistogram("connect", total.connectTime);
+        printHistogram("first byte", total.firstByteTime);
+        printHistogram("teardown", total.teardownTime);
+        fflush(stdout);
+    }
+}
+
+/*
+    ./connstorm_bench [seconds] [client_threads] [server_threads...]
+    ./connstorm_bench 5 8 0 1 2 4
+*/
+int main(int argc, char *argv[])
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    int clientThreads = argc > 2 ? std::max(atoi(argv[2]), 1) : 4;
+    std::vector<int> serverThreads;
+    for (int i = 3; i < argc; ++i)
+    {
+        serverThreads.push_back(atoi(argv[i]));
+    }
+    if (serverThreads.empty())
+    {
+        serverThreads = {0, 1, 2, 4};
+    }
+
+    printf("duration=%.1fs cpus=%u\n", seconds, std::thread::hardware_concurrency());
+    // 端口不能在本地临时端口范围（默认 32768 ~ 60999）内，否则客户端 socket 可能恰好分配到
+    // 与服务端相同的端口而发生自连接
+    uint16_t port = 24601;
+    for (int threads : serverThreads)
+    {
+        runRound(port++, threads, clientThreads, seconds);
+    }
+
+    // 服务端没有提供停止接口，直接退出进程
+    std::quick_exit(0);
+}
@@ -0,0 +1,332 @@
+#include "stnl/TcpServer.h"
+#include "stnl/TcpConnection.h"
+#include "stnl/Channel.h"
+#include "stnl/Socket.h"
+#include "stnl/Buffer.h"
+#include "stnl/EventLoop.h"
+#include "stnl/TimeUtil.h"
+#include "stnl/Timer.h"
+#include "stnl/logger.h"
+
+#include "../latency/Histogram.h"
+
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace stnl;
+
+/**
+ * 大量空闲连接（C10K ~ C1M）的扩展性测试。
+ *
+ * 服务端（echo）运行在 fork 出的子进程中，父进程作为客户端逐步建立连接，
+ * 从 /proc/<pid>/status 读取服务端的 VmRSS，得到每个连接的实际内存占用（用户态部分，不含内核 socket 缓冲区）。
+ * 客户端轮流绑定 127.0.0.1 ~ 127.0.0.N 作为源地址，每个源地址可以使用一整段临时端口，
+ * 避免单个 (源地址, 目的地址) 组合的端口耗尽。
+ *
+ * 连接建立完成后：
+ * 1. 随机选择连接发送 8 字节的心跳，测量往返时间；
+ * 2. 通过一个连接向服务端发送探测请求，服务端在该连接所属的 loop 上连续设置 1ms 的定时器，
+ *    统计定时器回调比预定时间晚了多久，即大量空闲连接注册在 loop 中时 loop 单次迭代（epoll_wait 返回到执行回调）的延迟，
+ *    结果（纳秒）回传给客户端。
+ *
+ * 连接数受 RLIMIT_NOFILE 限制（每个进程各持有一端），程序会尝试把软限制提高到硬限制。
+ */
+
+namespace
+{
+    int64_t nowNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /**
+     * 进程的常驻内存（KB）
+     */
+    long residentKilobytes(pid_t pid)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/status", static_cast<int>(pid));
+        FILE *fp = ::fopen(path, "r");
+        if (!fp)
+        {
+            return -1;
+        }
+        char line[256];
+        long rss = -1;
+        while (::fgets(line, sizeof(line), fp))
+        {
+            if (::strncmp(line, "VmRSS:", 6) == 0)
+            {
+                rss = ::atol(line + 6);
+                break;
+            }
+        }
+        ::fclose(fp);
+        return rss;
+    }
+
+    rlim_t raiseFileLimit()
+    {
+        struct rlimit limit;
+        ::getrlimit(RLIMIT_NOFILE, &limit);
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+        ::getrlimit(RLIMIT_NOFILE, &limit);
+        return limit.rlim_cur;
+    }
+
+    const char ProbeRequest = 'P';
+    const int ProbeTimers = 1000;
+    const double ProbeInterval = 0.001;
+
+    struct LoopProbe
+    {
+        Histogram lateness;
+        int remaining = ProbeTimers;
+    };
+
+    /**
+     * 在连接所属的 loop 上设置下一个定时器，全部完成后把延迟的分位数回传给客户端
+     */
+    void probeLoop(const TcpConnection::TcpConnectionPtr &conn, const std::shared_ptr<LoopProbe> &probe)
+    {
+        int64_t expected = nowNanoseconds() + static_cast<int64_t>(ProbeInterval * 1e9);
+        conn->getLoop()->runAfter(ProbeInterval, [conn, probe, expected]() {
+            probe->lateness.record(nowNanoseconds() - expected);
+            if (--probe->remaining > 0)
+            {
+                probeLoop(conn, probe);
+                return;
+            }
+            int64_t result[4] = {probe->lateness.valueAtPercentile(50), probe->lateness.valueAtPercentile(99),
+                                 probe->lateness.valueAtPercentile(99.9), probe->lateness.max()};
+            conn->send(std::string_view(reinterpret_cast<const char *>(result), sizeof(result)));
+        });
+    }
+
+    void runServer(uint16_t port, int threadNums)
+    {
+        TcpServer server(SockAddr("127.0.0.1", port), "idleconn-server", threadNums);
+        server.setMessageCallback([](const TcpConnection::TcpConnectionPtr &conn, NetBuffer *buf, Timestamp) {
+            if (buf->readableBytes() == 1 && *buf->peek() == ProbeRequest)
+            {
+                buf->retrieveAll();
+                probeLoop(conn, std::make_shared<LoopProbe>());
+                return;
+            }
+            conn->send(buf);
+        });
+        server.start();
+    }
+
+    bool readFully(int fd, void *data, size_t len, int timeoutMs)
+    {
+        char *p = static_cast<char *>(data);
+        while (len > 0)
+        {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            if (::poll(&pfd, 1, timeoutMs) != 1)
+            {
+                return false;
+            }
+            ssize_t n = ::read(fd, p, len);
+            if (n <= 0)
+            {
+                return false;
+            }
+            p += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    int connectFrom(int sourceIndex, uint16_t port)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            return -1;
+        }
+
+        struct sockaddr_in source;
+        ::memset(&source, 0, sizeof(source));
+        source.sin_family = AF_INET;
+        source.sin_addr.s_addr = htonl(INADDR_LOOPBACK + static_cast<uint32_t>(sourceIndex));
+        source.sin_port = 0;
+
+        struct sockaddr_in server;
+        ::memset(&server, 0, sizeof(server));
+        server.sin_family = AF_INET;
+        server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        server.sin_port = htons(port);
+
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (::bind(fd, reinterpret_cast<struct sockaddr *>(&source), sizeof(source)) < 0 ||
+            ::connect(fd, reinterpret_cast<struct sockaddr *>(&server), sizeof(server)) < 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void printSizes()
+    {
+        printf("sizeof: TcpConnection=%zu NetBuffer=%zu Channel=%zu Socket=%zu SockAddr=%zu std::string=%zu\n",
+               sizeof(TcpConnection), sizeof(NetBuffer), sizeof(Channel), sizeof(Socket),
+               sizeof(SockAddr), sizeof(std::string));
+    }
+
+    void printHistogram(const char *name, const Histogram &histogram)
+    {
+        printf("%-22s p50=%8.1fus p99=%8.1fus p99.9=%8.1fus max=%8.1fus\n", name,
+               static_cast<double>(histogram.valueAtPercentile(50)) / 1000.0,
+               static_cast<double>(histogram.valueAtPercentile(99)) / 1000.0,
+               static_cast<double>(histogram.valueAtPercentile(99.9)) / 1000.0,
+               static_cast<double>(histogram.max()) / 1000.0);
+    }
+}
+
+/*
+    ./idleconn_bench [connections] [source_ips] [server_threads] [heartbeats]
+    ./idleconn_bench 100000 8 4 10000
+*/
+int main(int argc, char *argv[])
+{
+    int target = argc > 1 ? atoi(argv[1]) : 10000;
+    int sourceIps = argc > 2 ? std::max(atoi(argv[2]), 1) : 4;
+    int serverThreads = argc > 3 ? atoi(argv[3]) : 1;
+    int heartbeats = argc > 4 ? atoi(argv[4]) : 10000;
+    const uint16_t port = 24701;
+
+    rlim_t fileLimit = raiseFileLimit();
+    if (static_cast<rlim_t>(target) + 64 > fileLimit)
+    {
+        printf("RLIMIT_NOFILE is %llu, connections limited\n", static_cast<unsigned long long>(fileLimit));
+        target = static_cast<int>(fileLimit) - 64;
+    }
+    printSizes();
+
+    pid_t server = ::fork();
+    if (server == 0)
+    {
+        // 服务端的日志不与测试结果混在一起
+        int devNull = ::open("/dev/null", O_WRONLY);
+        ::dup2(devNull, STDOUT_FILENO);
+        runServer(port, serverThreads);
+        ::_exit(0);
+    }
+    ::usleep(200 * 1000);
+
+    long baseRss = residentKilobytes(server);
+    printf("server pid=%d threads=%d baseline rss=%ldKB\n", static_cast<int>(server), serverThreads, baseRss);
+
+    // 1. 逐步建立连接
+    std::vector<int> fds;
+    fds.reserve(target);
+    int failures = 0;
+    int step = std::max(target / 10, 1);
+    auto rampStart = std::chrono::steady_clock::now();
+    while (static_cast<int>(fds.size()) < target && failures < 1000)
+    {
+        int fd = connectFrom(static_cast<int>(fds.size()) % sourceIps, port);
+        if (fd < 0)
+        {
+            ++failures;
+            continue;
+        }
+        fds.push_back(fd);
+
+        if (static_cast<int>(fds.size()) % step == 0)
+        {
+            // 等待服务端处理完 accept
+            ::usleep(100 * 1000);
+            long rss = residentKilobytes(server);
+            printf("connections=%7zu rss=%8ldKB per connection=%6.0f bytes\n", fds.size(), rss,
+                   static_cast<double>(rss - baseRss) * 1024.0 / static_cast<double>(fds.size()));
+            fflush(stdout);
+        }
+    }
+    double rampSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - rampStart).count();
+    printf("established %zu connections in %.1fs (%d failures)\n", fds.size(), rampSeconds, failures);
+    if (fds.empty())
+    {
+        ::kill(server, SIGKILL);
+        ::waitpid(server, nullptr, 0);
+        return 1;
+    }
+
+    // 2. 心跳往返时间：其余连接保持空闲
+    Histogram heartbeatRtt;
+    std::mt19937 random(12345);
+    int timeouts = 0;
+    for (int i = 0; i < heartbeats; ++i)
+    {
+        int fd = fds[random() % fds.size()];
+        int64_t start = nowNanoseconds();
+        if (::write(fd, &start, sizeof(start)) != sizeof(start))
+        {
+            ++timeouts;
+            continue;
+        }
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int64_t echo;
+        if (::poll(&pfd, 1, 1000) != 1 || ::read(fd, &echo, sizeof(echo)) != sizeof(echo))
+        {
+            ++timeouts;
+            continue;
+        }
+        heartbeatRtt.record(nowNanoseconds() - start);
+    }
+    printHistogram("heartbeat rtt", heartbeatRtt);
+    if (timeouts > 0)
+    {
+        printf("heartbeat timeouts=%d\n", timeouts);
+    }
+
+    // 3. 服务端 loop 的迭代延迟：其中一个连接所属的 loop 上的定时器比预定时间晚了多久
+    int64_t lateness[4];
+    if (::write(fds[0], &ProbeRequest, sizeof(ProbeRequest)) == sizeof(ProbeRequest) &&
+        readFully(fds[0], lateness, sizeof(lateness), 10 * 1000))
+    {
+        printf("%-22s p50=%8.1fus p99=%8.1fus p99.9=%8.1fus max=%8.1fus\n", "server loop timer late",
+               static_cast<double>(lateness[0]) / 1000.0, static_cast<double>(lateness[1]) / 1000.0,
+               static_cast<double>(lateness[2]) / 1000.0, static_cast<double>(lateness[3]) / 1000.0);
+    }
+    else
+    {
+        printf("server loop probe failed\n");
+    }
+
+    long rss = residentKilobytes(server);
+    printf("final: connections=%zu server rss=%ldKB per connection=%.0f bytes\n", fds.size(), rss,
+           static_cast<double>(rss - baseRss) * 1024.0 / static_cast<double>(fds.size()));
+
+    for (int fd : fds)
+    {
+        ::close(fd);
+    }
+    ::kill(server, SIGKILL);
+    ::waitpid(server, nullptr, 0);
+}
@@ -0,0 +1,229 @@
+#ifndef STNL_BENCHMARK_HISTOGRAM_H
+#define STNL_BENCHMARK_HISTOGRAM_H
+
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+/**
+ * @brief 简化的 HDR（High Dynamic Range）直方图，用于记录延迟分布
+ *
+ * 与 HdrHistogram 的布局相同：值按 2 的幂划分为若干 bucket，每个 bucket 再线性划分为
+ * subBucketCount / 2 个 sub-bucket，因此在整个取值范围内相对误差不超过 10^-significantDigits。
+ * 记录一个值只需要几次位运算和一次计数器自增，可以在 loop 线程的回调中直接调用。
+ *
+ * 不是线程安全的，多线程记录时每个线程各用一个实例，最后 merge。
+ */
+class Histogram
+{
+public:
+    /**
+     * @param highestTrackableValue 可记录的最大值，更大的值按最大值记录
+     * @param significantDigits 有效数字位数，1 ~ 5
+     */
+    explicit Histogram(int64_t highestTrackableValue = 3600LL * 1000 * 1000 * 1000, int significantDigits = 3)
+        : highestTrackableValue_(highestTrackableValue),
+          totalCount_(0),
+          minValue_(INT64_MAX),
+          maxValue_(0)
+    {
+        int64_t largestValueWithSingleUnitResolution = 2 * static_cast<int64_t>(std::pow(10, significantDigits));
+        int subBucketCountMagnitude = static_cast<int>(std::ceil(std::log2(static_cast<double>(largestValueWithSingleUnitResolution))));
+        subBucketHalfCountMagnitude_ = std::max(subBucketCountMagnitude, 1) - 1;
+        subBucketCount_ = int64_t(1) << (subBucketHalfCountMagnitude_ + 1);
+        subBucketHalfCount_ = subBucketCount_ / 2;
+        subBucketMask_ = subBucketCount_ - 1;
+
+        int bucketCount = 1;
+        int64_t smallestUntrackableValue = subBucketCount_;
+        while (smallestUntrackableValue <= highestTrackableValue_)
+        {
+            if (smallestUntrackableValue > INT64_MAX / 2)
+            {
+                ++bucketCount;
+                break;
+            }
+            smallestUntrackableValue <<= 1;
+            ++bucketCount;
+        }
+        counts_.assign(static_cast<size_t>((bucketCount + 1) * subBucketHalfCount_), 0);
+    }
+
+    void record(int64_t value)
+    {
+        value = std::clamp<int64_t>(value, 0, highestTrackableValue_);
+        ++counts_[countsIndex(value)];
+        ++totalCount_;
+        minValue_ = std::min(minValue_, value);
+        maxValue_ = std::max(maxValue_, value);
+    }
+
+    /**
+     * 开环测试中，若一个请求的延迟为 value，而请求本应每隔 expectedInterval 发送一次，
+     * 那么被它阻塞而没有发出的请求也应当计入，以避免 coordinated omission。
+     * 本基准测试的客户端按计划时间计算延迟，不需要此修正，提供给闭环测试使用。
+     */
+    void recordCorrected(int64_t value, int64_t expectedInterval)
+    {
+        record(value);
+        if (expectedInterval <= 0)
+        {
+            return;
+        }
+        for (int64_t missing = value - expectedInterval; missing >= expectedInterval; missing -= expectedInterval)
+        {
+            record(missing);
+        }
+    }
+
+    void merge(const Histogram &other)
+    {
+        for (size_t i = 0; i < other.counts_.size(); ++i)
+        {
+            if (other.counts_[i] != 0)
+            {
+                record(other.valueFromIndex(i), other.counts_[i]);
+            }
+        }
+    }
+
+    void reset()
+    {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        totalCount_ = 0;
+        minValue_ = INT64_MAX;
+        maxValue_ = 0;
+    }
+
+    int64_t count() const { return totalCount_; }
+
+    int64_t min() const { return totalCount_ == 0 ? 0 : minValue_; }
+
+    int64_t max() const { return maxValue_; }
+
+    double mean() const
+    {
+        if (totalCount_ == 0)
+        {
+            return 0.0;
+        }
+        double total = 0.0;
+        for (size_t i = 0; i < counts_.size(); ++i)
+        {
+            if (counts_[i] != 0)
+            {
+                total += static_cast<double>(counts_[i]) * static_cast<double>(medianEquivalentValue(valueFromIndex(i)));
+            }
+        }
+        return total / static_cast<double>(totalCount_);
+    }
+
+    /**
+     * @param percentile 0 ~ 100
+     */
+    int64_t valueAtPercentile(double percentile) const
+    {
+        if (totalCount_ == 0)
+        {
+            return 0;
+        }
+        percentile = std::clamp(percentile, 0.0, 100.0);
+        int64_t countAtPercentile = static_cast<int64_t>(percentile / 100.0 * static_cast<double>(totalCount_) + 0.5);
+        countAtPercentile = std::max<int64_t>(countAtPercentile, 1);
+
+        int64_t total = 0;
+        for (size_t i = 0; i < counts_.size(); ++i)
+        {
+            total += counts_[i];
+            if (total >= countAtPercentile)
+            {
+                return std::min(highestEquivalentValue(valueFromIndex(i)), maxValue_);
+            }
+        }
+        return maxValue_;
+    }
+
+    /**
+     * 打印常用的百分位，value 除以 unitScale 后以 unitName 为单位输出
+     */
+    void print(FILE *out, double unitScale = 1000.0, const char *unitName = "us") const
+    {
+        fprintf(out, "count=%lld min=%.1f%s mean=%.1f%s\n",
+                static_cast<long long>(totalCount_),
+                static_cast<double>(min()) / unitScale, unitName,
+                mean() / unitScale, unitName);
+        const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+        for (double p : percentiles)
+        {
+            fprintf(out, "  p%-6g %10.1f%s\n", p, static_cast<double>(valueAtPercentile(p)) / unitScale, unitName);
+        }
+        fprintf(out, "  max     %10.1f%s\n", static_cast<double>(max()) / unitScale, unitName);
+    }
+
+private:
+    void record(int64_t value, int64_t count)
+    {
+        value = std::clamp<int64_t>(value, 0, highestTrackableValue_);
+        counts_[countsIndex(value)] += count;
+        totalCount_ += count;
+        minValue_ = std::min(minValue_, value);
+        maxValue_ = std::max(maxValue_, value);
+    }
+
+    int bucketIndex(int64_t value) const
+    {
+        // value 所在的 2 的幂区间，小于 subBucketCount 的值都在 bucket 0
+        int pow2Ceiling = 64 - __builtin_clzll(static_cast<uint64_t>(value | subBucketMask_));
+        return pow2Ceiling - (subBucketHalfCountMagnitude_ + 1);
+    }
+
+    size_t countsIndex(int64_t value) const
+    {
+        int bucket = bucketIndex(value);
+        int64_t subBucket = value >> bucket;
+        int64_t base = static_cast<int64_t>(bucket + 1) << subBucketHalfCountMagnitude_;
+        return static_cast<size_t>(base + (subBucket - subBucketHalfCount_));
+    }
+
+    int64_t valueFromIndex(size_t index) const
+    {
+        int bucket = static_cast<int>(index >> subBucketHalfCountMagnitude_) - 1;
+        int64_t subBucket = static_cast<int64_t>(index & (subBucketHalfCount_ - 1)) + subBucketHalfCount_;
+        if (bucket < 0)
+        {
+            subBucket -= subBucketHalfCount_;
+            bucket = 0;
+        }
+        return subBucket << bucket;
+    }
+
+    int64_t sizeOfEquivalentRange(int64_t value) const
+    {
+        return int64_t(1) << bucketIndex(value);
+    }
+
+    int64_t highestEquivalentValue(int64_t value) const
+    {
+        return value + sizeOfEquivalentRange(value) - 1;
+    }
+
+    int64_t medianEquivalentValue(int64_t value) const
+    {
+        return value + sizeOfEquivalentRange(value) / 2;
+    }
+
+private:
+    int64_t highestTrackableValue_;
+    int subBucketHalfCountMagnitude_;
+    int64_t subBucketCount_;
+    int64_t subBucketHalfCount_;
+    int64_t subBucketMask_;
+    std::vector<int64_t> counts_;
+    int64_t totalCount_;
+    int64_t minValue_;
+    int64_t maxValue_;
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include "stnl/TcpClient.h"
+#include "stnl/EventLoop.h"
+#include "stnl/TimeUtil.h"
+#include "stnl/Timer.h"
+#include "stnl/logger.h"
+
+#include "Histogram.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace stnl;
+using namespace std::placeholders;
+
+/**
+ * 开环（open-loop）延迟测试客户端，配合 throughput/pingpong_server 使用。
+ *
+ * 每个连接按固定速率发送 16 字节的消息：8 字节序号 + 8 字节计划发送时间（steady_clock 纳秒）。
+ * 发送时间由速率预先决定，与是否收到上一条回复无关；往返时间从计划发送时间开始计算，
+ * 因此服务端或客户端的停顿会体现在之后所有消息的延迟上，避免 coordinated omission。
+ */
+
+namespace
+{
+    const size_t MessageSize = 2 * sizeof(int64_t);
+
+    int64_t nowNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+}
+
+class Session : public noncopyable
+{
+public:
+    Session(EventLoop *loop, const SockAddr &serverAddr, const std::string &name, Histogram *histogram)
+        : client_(loop, serverAddr, name),
+          histogram_(histogram),
+          sent_(0),
+          received_(0),
+          recordAfter_(0)
+    {
+        client_.setConnectionCallback(std::bind(&Session::onConnection, this, _1));
+        client_.setMessageCallback(std::bind(&Session::onMessage, this, _1, _2, _3));
+    }
+
+    void connect() { client_.connect(); }
+
+    void disconnect() { client_.disconnect(); }
+
+    bool connected() const { return static_cast<bool>(conn_); }
+
+    /**
+     * 只记录计划发送时间不早于 time 的消息的延迟（预热阶段的消息不计入）
+     */
+    void recordAfter(int64_t time) { recordAfter_ = time; }
+
+    void send(int64_t intendedTime)
+    {
+        if (!conn_)
+        {
+            return;
+        }
+        char message[MessageSize];
+        int64_t seq = sent_++;
+        ::memcpy(message, &seq, sizeof(seq));
+        ::memcpy(message + sizeof(seq), &intendedTime, sizeof(intendedTime));
+        conn_->send(message, MessageSize);
+    }
+
+    int64_t sent() const { return sent_; }
+
+    int64_t received() const { return received_; }
+
+private:
+    void onConnection(const TcpConnection::TcpConnectionPtr &conn)
+    {
+        if (conn->isConnected())
+        {
+            conn->setTcpNoDelay(true);
+            conn_ = conn;
+        }
+        else
+        {
+            conn_.reset();
+        }
+    }
+
+    void onMessage(const TcpConnection::TcpConnectionPtr &, NetBuffer *buf, Timestamp)
+    {
+        int64_t now = nowNanoseconds();
+        while (buf->readableBytes() >= MessageSize)
+        {
+            int64_t intendedTime;
+            ::memcpy(&intendedTime, buf->peek() + sizeof(int64_t), sizeof(intendedTime));
+            buf->retrieve(MessageSize);
+            ++received_;
+            if (intendedTime >= recordAfter_)
+            {
+                histogram_->record(now - intendedTime);
+            }
+        }
+    }
+
+    TcpClient client_;
+    TcpConnection::TcpConnectionPtr conn_;
+    Histogram *histogram_;
+    int64_t sent_;
+    int64_t received_;
+    int64_t recordAfter_;
+};
+
+class LatencyClient : public noncopyable
+{
+public:
+    LatencyClient(EventLoop *loop, const SockAddr &serverAddr, int sessionCount, double rate,
+                  double seconds, double warmupSeconds)
+        : loop_(loop),
+          rate_(rate),
+          seconds_(seconds),
+          warmupSeconds_(warmupSeconds),
+          startTime_(0),
+          scheduled_(0),
+          connected_(false),
+          finished_(false)
+    {
+        for (int i = 0; i < sessionCount; ++i)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "L%05d", i);
+            sessions_.emplace_back(new Session(loop, serverAddr, name, &histogram_));
+            sessions_.back()->connect();
+        }
+        // 按速率计算应发送的消息数，定时器只负责推进时间，间隔不影响消息的计划发送时间
+        double tick = std::max(1.0 / rate_, 0.0001);
+        loop_->runEvery(tick, std::bind(&LatencyClient::onTick, this));
+    }
+
+    void report() const
+    {
+        int64_t sent = 0;
+        int64_t received = 0;
+        for (const auto &session : sessions_)
+        {
+            sent += session->sent();
+            received += session->received();
+        }
+        printf("connections=%zu rate=%.0f msg/s duration=%.1fs warmup=%.1fs sent=%lld received=%lld\n",
+               sessions_.size(), rate_, seconds_, warmupSeconds_,
+               static_cast<long long>(sent), static_cast<long long>(received));
+        histogram_.print(stdout);
+    }
+
+private:
+    void onTick()
+    {
+        if (!connected_)
+        {
+            for (const auto &session : sessions_)
+            {
+                if (!session->connected())
+                {
+                    return;
+                }
+            }
+            connected_ = true;
+            startTime_ = nowNanoseconds();
+            int64_t recordAfter = startTime_ + static_cast<int64_t>(warmupSeconds_ * 1e9);
+            for (const auto &session : sessions_)
+            {
+                session->recordAfter(recordAfter);
+            }
+        }
+
+        int64_t now = nowNanoseconds();
+        double elapsed = static_cast<double>(now - startTime_) / 1e9;
+        if (elapsed >= warmupSeconds_ + seconds_)
+        {
+            finish();
+            return;
+        }
+
+        // 补发所有计划时间已到的消息，每条消息携带自己的计划发送时间。
+        // 第 0 条消息的计划时间为 startTime_，与定时器的相位对齐，定时器本身的延迟计入测量结果
+        int64_t due = static_cast<int64_t>(elapsed * rate_) + 1;
+        for (; scheduled_ < due; ++scheduled_)
+        {
+            int64_t intendedTime = startTime_ + static_cast<int64_t>(static_cast<double>(scheduled_) * 1e9 / rate_);
+            sessions_[static_cast<size_t>(scheduled_) % sessions_.size()]->send(intendedTime);
+        }
+    }
+
+    void finish()
+    {
+        if (finished_)
+        {
+            return;
+        }
+        finished_ = true;
+        // 等待在途的回复
+        loop_->runAfter(0.5, [this]() {
+            report();
+            for (const auto &session : sessions_)
+            {
+                session->disconnect();
+            }
+            loop_->runAfter(0.1, std::bind(&EventLoop::quit, loop_));
+        });
+    }
+
+    EventLoop *loop_;
+    double rate_;
+    double seconds_;
+    double warmupSeconds_;
+    int64_t startTime_;
+    int64_t scheduled_;
+    bool connected_;
+    bool finished_;
+    Histogram histogram_;
+    std::vector<std::unique_ptr<Session>> sessions_;
+};
+
+/*
+    ./pingpong_server 127.0.0.1 33333 1
+    ./latency_client 127.0.0.1 33333 <connections> <rate msg/s> <seconds> [warmup seconds]
+    ./latency_client 127.0.0.1 33333 10 20000 10 2
+*/
+int main(int argc, char *argv[])
+{
+    if (argc < 6)
+    {
+        fprintf(stderr, "Usage: %s <host_ip> <port> <connections> <rate> <seconds> [warmup]\n", argv[0]);
+        return 1;
+    }
+
+    SockAddr serverAddr(argv[1], static_cast<uint16_t>(atoi(argv[2])));
+    int connections = std::max(atoi(argv[3]), 1);
+    double rate = std::max(atof(argv[4]), 1.0);
+    double seconds = atof(argv[5]);
+    double warmup = argc > 6 ? atof(argv[6]) : 1.0;
+
+    EventLoop loop;
+    LatencyClient client(&loop, serverAddr, connections, rate, seconds, warmup);
+    loop.loop();
+}
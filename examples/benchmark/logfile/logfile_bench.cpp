@@ -0,0 +1,186 @@
+#include "stnl/logger.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+
+using namespace stnl;
+
+/**
+ * 日志文件写入方式（LogFileType）的对比测试：Stdio（stdio 缓冲）、Direct（writev）、Mmap（预分配 + mmap 窗口）。
+ *
+ * 1. LogFile：与 AsyncLogging 后端相同，每次 append 一整块 4MB 的日志，测量写入速率和写入线程的 CPU 时间；
+ * 2. AsyncLogging：多个线程用 LOG_INFO 写日志，从开始写到 stop() 返回（后端写完所有日志）为止，
+ *    测量端到端的速率，后端线程的 CPU 时间 = 进程的 CPU 时间 - 各写日志线程的 CPU 时间。
+ *
+ * 落盘：Stdio 与 Direct 的 flush 只把数据交给页缓存，从不 fsync；Mmap 的 flush 每隔 syncInterval 秒 msync(MS_SYNC) 一次。
+ * 1 中 Mmap 的 syncInterval 设为 INT_MAX，三种方式都只写到页缓存，结果不包括落盘的时间；
+ * 2 中 Mmap 按 FileHandler 的 flushInterval（3 秒）同步写回，结果包括周期性 msync 的时间，而 Stdio 与 Direct 不包括。
+ * 测试目录在测试结束后删除。
+ */
+
+namespace
+{
+    const size_t LineSize = 100;
+
+    double cpuSeconds(clockid_t clock)
+    {
+        struct timespec ts;
+        ::clock_gettime(clock, &ts);
+        return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+    }
+
+    const char *fileTypeName(LogFileType fileType)
+    {
+        switch (fileType)
+        {
+        case LogFileType::Direct:
+            return "direct";
+        case LogFileType::Mmap:
+            return "mmap";
+        default:
+            return "stdio";
+        }
+    }
+
+    LogFile *newLogFile(LogFileType fileType, const std::string &filename, off_t fileSize)
+    {
+        switch (fileType)
+        {
+        case LogFileType::Direct:
+            return new DirectLogFile(filename);
+        case LogFileType::Mmap:
+            // 不 msync，与 Stdio、Direct 一样只写到页缓存
+            return new MappedLogFile(filename, fileSize, INT_MAX);
+        default:
+            return new StdioLogFile(filename);
+        }
+    }
+
+    void benchLogFile(LogFileType fileType, size_t totalBytes)
+    {
+        // 一块 Buffer 中都是 LineSize 字节的日志
+        std::string block;
+        while (block.size() + LineSize <= static_cast<size_t>(AsyncBufferSize))
+        {
+            char line[LineSize + 1];
+            snprintf(line, sizeof(line), "%-*zu\n", static_cast<int>(LineSize - 1), block.size() / LineSize);
+            block.append(line, LineSize);
+        }
+        size_t blocks = std::max<size_t>(totalBytes / block.size(), 1);
+        std::string filename = std::string(fileTypeName(fileType)) + ".log";
+
+        double cpuStart = cpuSeconds(CLOCK_THREAD_CPUTIME_ID);
+        auto start = std::chrono::steady_clock::now();
+        {
+            std::unique_ptr<LogFile> file(newLogFile(fileType, filename, static_cast<off_t>(blocks * block.size())));
+            for (size_t i = 0; i < blocks; ++i)
+            {
+                file->append(block.data(), static_cast<int>(block.size()));
+                file->flush();
+            }
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double cpu = cpuSeconds(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+
+        double lines = static_cast<double>(blocks * block.size() / LineSize);
+        double megabytes = static_cast<double>(blocks * block.size()) / (1024 * 1024);
+        printf("LogFile      %-6s %10.0f lines/s %8.1f MB/s cpu=%.3fs (%.1fms per 100MB)\n", fileTypeName(fileType),
+               lines / elapsed, megabytes / elapsed, cpu, cpu * 1000 / megabytes * 100);
+        std::filesystem::remove(filename);
+    }
+
+    void benchAsyncLogging(LogFileType fileType, int threadNums, int linesPerThread)
+    {
+        std::filesystem::create_directory(fileTypeName(fileType));
+        std::filesystem::current_path(fileTypeName(fileType));
+
+        std::shared_ptr<AsyncLogging> asyncLogger =
+            std::make_shared<AsyncLogging>(".", LogLevel::INFO, 256 * 1024 * 1024, 3, 100 * 100);
+        asyncLogger->setLogFileType(fileType);
+        asyncLogger->start();
+        Logger::instance().setAsyncLogger(asyncLogger);
+
+        std::vector<double> producerCpu(threadNums);
+        std::vector<std::thread> threads;
+        double cpuStart = cpuSeconds(CLOCK_PROCESS_CPUTIME_ID);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < threadNums; ++i)
+        {
+            threads.emplace_back([&producerCpu, i, linesPerThread]() {
+                double threadStart = cpuSeconds(CLOCK_THREAD_CPUTIME_ID);
+                for (int n = 0; n < linesPerThread; ++n)
+                {
+                    LOG_INFO << "logfile bench line " << n << " from producer " << i << " abcdefghijklmnopqrstuvwxyz";
+                }
+                producerCpu[i] = cpuSeconds(CLOCK_THREAD_CPUTIME_ID) - threadStart;
+            });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        Logger::instance().setAsyncLogger(nullptr);
+        asyncLogger->stop();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double cpu = cpuSeconds(CLOCK_PROCESS_CPUTIME_ID) - cpuStart;
+        for (double producer : producerCpu)
+        {
+            cpu -= producer;
+        }
+
+        double lines = static_cast<double>(threadNums) * linesPerThread;
+        printf("AsyncLogging %-6s %10.0f lines/s backend cpu=%.3fs (%.2fus per line) dropped=%llu\n",
+               fileTypeName(fileType), lines / elapsed, cpu, cpu * 1e6 / lines,
+               static_cast<unsigned long long>(asyncLogger->droppedLines()));
+
+        std::filesystem::current_path("..");
+        std::filesystem::remove_all(fileTypeName(fileType));
+    }
+}
+
+/*
+    ./logfile_bench [dir] [LogFile MB] [AsyncLogging threads] [lines per thread]
+    ./logfile_bench /tmp 1024 4 1000000
+*/
+int main(int argc, char *argv[])
+{
+    std::string dir = argc > 1 ? argv[1] : ".";
+    size_t totalBytes = static_cast<size_t>(argc > 2 ? atoi(argv[2]) : 512) * 1024 * 1024;
+    int threadNums = argc > 3 ? std::max(atoi(argv[3]), 1) : 2;
+    int linesPerThread = argc > 4 ? atoi(argv[4]) : 1000000;
+
+    // FileHandler 在当前目录下创建日志文件
+    std::string testDir = dir + "/logfile_bench_XXXXXX";
+    if (::mkdtemp(testDir.data()) == nullptr)
+    {
+        fprintf(stderr, "mkdtemp %s failed %s\n", testDir.c_str(), strerror(errno));
+        return 1;
+    }
+    std::filesystem::path oldPath = std::filesystem::current_path();
+    std::filesystem::current_path(testDir);
+
+    const LogFileType fileTypes[] = {LogFileType::Stdio, LogFileType::Direct, LogFileType::Mmap};
+    for (LogFileType fileType : fileTypes)
+    {
+        benchLogFile(fileType, totalBytes);
+    }
+    for (LogFileType fileType : fileTypes)
+    {
+        benchAsyncLogging(fileType, threadNums, linesPerThread);
+    }
+
+    std::filesystem::current_path(oldPath);
+    std::filesystem::remove_all(testDir);
+}
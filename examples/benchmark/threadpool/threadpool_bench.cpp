@@ -0,0 +1,168 @@
+#include "stnl/ThreadPool.h"
+#include "stnl/CountDownLatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <thread>
+#include <vector>
+
+using namespace stnl;
+
+/**
+ * 对照组：所有线程共用一个由 mutex 保护的任务队列。
+ */
+class MutexQueuePool : noncopyable
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit MutexQueuePool(int threadNums) : running_(true)
+    {
+        for (int i = 0; i < threadNums; ++i)
+        {
+            threads_.emplace_back(&MutexQueuePool::workerFunc, this);
+        }
+    }
+
+    ~MutexQueuePool()
+    {
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            running_ = false;
+        }
+        cv_.notify_all();
+        for (auto &thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    void post(Task task)
+    {
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            tasks_.emplace_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void workerFunc()
+    {
+        while (true)
+        {
+            Task task;
+            {
+                std::unique_lock<std::mutex> locker(mutex_);
+                cv_.wait(locker, [this]() { return !running_ || !tasks_.empty(); });
+                if (tasks_.empty())
+                {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    bool running_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Task> tasks_;
+    std::vector<std::thread> threads_;
+};
+
+using Clock = std::chrono::steady_clock;
+
+void spin(int iterations)
+{
+    volatile int x = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        x = x + i;
+    }
+}
+
+struct Result
+{
+    double tasksPerSecond;
+    double p50Us;
+    double p99Us;
+};
+
+/**
+ * producers 个线程各提交 tasksPerProducer 个任务，每个任务空转 work 次循环。
+ * 延迟为任务从提交到开始执行的时间。
+ */
+template <typename Pool>
+Result run(Pool &pool, int producers, int tasksPerProducer, int work)
+{
+    const int total = producers * tasksPerProducer;
+    std::vector<int64_t> latencies(total);
+    CountDownLatch latch(total);
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < tasksPerProducer; ++i)
+            {
+                int slot = p * tasksPerProducer + i;
+                auto submitTime = Clock::now();
+                pool.post([&, slot, submitTime]() {
+                    latencies[slot] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - submitTime).count();
+                    spin(work);
+                    latch.countDown();
+                });
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    latch.wait();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    Result result;
+    result.tasksPerSecond = total / seconds;
+    result.p50Us = latencies[total / 2] / 1000.0;
+    result.p99Us = latencies[total * 99 / 100] / 1000.0;
+    return result;
+}
+
+/*
+    ./threadpool_bench [threads] [producers] [tasksPerProducer]
+*/
+int main(int argc, char *argv[])
+{
+    int threadNums = argc > 1 ? atoi(argv[1]) : 4;
+    int producers = argc > 2 ? atoi(argv[2]) : 4;
+    int tasksPerProducer = argc > 3 ? atoi(argv[3]) : 100000;
+
+    printf("threads = %d, producers = %d, tasks = %d\n", threadNums, producers, producers * tasksPerProducer);
+    for (int work : {0, 100, 1000})
+    {
+        Result stealing, mutexQueue;
+        {
+            ThreadPool pool("bench", threadNums);
+            pool.start();
+            stealing = run(pool, producers, tasksPerProducer, work);
+        }
+        {
+            MutexQueuePool pool(threadNums);
+            mutexQueue = run(pool, producers, tasksPerProducer, work);
+        }
+        printf("work %5d: work-stealing %10.0f tasks/s p50 %8.1fus p99 %8.1fus | "
+               "mutex-queue %10.0f tasks/s p50 %8.1fus p99 %8.1fus\n",
+               work,
+               stealing.tasksPerSecond, stealing.p50Us, stealing.p99Us,
+               mutexQueue.tasksPerSecond, mutexQueue.p50Us, mutexQueue.p99Us);
+    }
+}
@@ -0,0 +1,234 @@
+#ifndef STNL_BINARYLOGGING_H
+#define STNL_BINARYLOGGING_H
+
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "logger.h"
+
+/**
+ * 二进制（延迟格式化）日志。
+ *
+ * LOG_BINARY_INFO("connection {} closed, {} bytes", name, bytes);
+ *
+ * 前端线程只拷贝调用点的静态信息（LogSite 的地址）、参数的解码函数以及参数的原始字节到
+ * AsyncLogging 的线程缓冲区中，时间、文件名、整数转换等格式化工作都由 AsyncLogging 的后端线程完成。
+ * 格式字符串中的 {} 依次被参数替换，参数的输出格式与 LogContext 的 operator<< 相同。
+ *
+ * 支持的参数类型：算术类型、枚举（输出底层整数值）、指针，以及字符串（const char*、std::string、std::string_view，按值拷贝）。
+ * 没有设置 AsyncLogging、FATAL 级别、参数总长度超过 LogBinaryMaxArgsSize 时，
+ * 退化为普通的日志语句，在当前线程格式化后交给 Logger 输出，因此可以与文本日志混合使用。
+ */
+
+namespace stnl
+{
+    const size_t LogBinaryMaxArgsSize = 1024;
+
+    /**
+     * @brief 参数的编码与解码：算术类型、枚举和指针直接拷贝原始字节
+     */
+    template <typename T, typename Enable = void>
+    struct LogArg
+    {
+        static_assert(std::is_arithmetic_v<T> || std::is_pointer_v<T>,
+                      "LOG_BINARY only supports arithmetic, enum, pointer and string arguments");
+
+        using Decoded = T;
+
+        static size_t size(const T &)
+        {
+            return sizeof(T);
+        }
+
+        static void encode(char *&p, const T &v)
+        {
+            memcpy(p, &v, sizeof(T));
+            p += sizeof(T);
+        }
+
+        static Decoded decode(const char *&p)
+        {
+            T v;
+            memcpy(&v, p, sizeof(T));
+            p += sizeof(T);
+            return v;
+        }
+    };
+
+    /**
+     * @brief 枚举（包括没有 operator<< 的 enum class）按底层整数类型编码，输出为整数
+     */
+    template <typename T>
+    struct LogArg<T, std::enable_if_t<std::is_enum_v<T>>>
+    {
+        using Underlying = std::underlying_type_t<T>;
+        using Decoded = decltype(+Underlying());     // 整数提升，底层类型为 char 时也输出为整数
+
+        static size_t size(const T &)
+        {
+            return sizeof(Underlying);
+        }
+
+        static void encode(char *&p, const T &v)
+        {
+            LogArg<Underlying>::encode(p, static_cast<Underlying>(v));
+        }
+
+        static Decoded decode(const char *&p)
+        {
+            return LogArg<Underlying>::decode(p);
+        }
+    };
+
+    /**
+     * @brief 在当前线程格式化时，参数的输出与后端线程解码后的输出相同
+     */
+    template <typename T>
+    decltype(auto) logArgValue(const T &arg)
+    {
+        if constexpr (std::is_enum_v<T>)
+        {
+            return +static_cast<std::underlying_type_t<T>>(arg);
+        }
+        else
+        {
+            return (arg);
+        }
+    }
+
+    /**
+     * @brief 字符串编码为 4 字节长度 + 内容，解码后直接引用后端线程中的字节，不再拷贝
+     */
+    struct LogStringArg
+    {
+        using Decoded = std::string_view;
+
+        static size_t size(std::string_view str)
+        {
+            return sizeof(uint32_t) + str.size();
+        }
+
+        static void encode(char *&p, std::string_view str)
+        {
+            uint32_t len = static_cast<uint32_t>(str.size());
+            memcpy(p, &len, sizeof(len));
+            memcpy(p + sizeof(len), str.data(), len);
+            p += sizeof(len) + len;
+        }
+
+        static Decoded decode(const char *&p)
+        {
+            uint32_t len;
+            memcpy(&len, p, sizeof(len));
+            std::string_view str(p + sizeof(len), len);
+            p += sizeof(len) + len;
+            return str;
+        }
+    };
+
+    template <typename T>
+    struct LogArg<T, std::enable_if_t<std::is_same_v<T, const char *> || std::is_same_v<T, char *>>>
+        : LogStringArg
+    {
+        static size_t size(const char *str)
+        {
+            return LogStringArg::size(str ? std::string_view(str) : std::string_view("(null)"));
+        }
+
+        static void encode(char *&p, const char *str)
+        {
+            LogStringArg::encode(p, str ? std::string_view(str) : std::string_view("(null)"));
+        }
+    };
+
+    template <>
+    struct LogArg<std::string> : LogStringArg
+    {
+    };
+
+    template <>
+    struct LogArg<std::string_view> : LogStringArg
+    {
+    };
+
+    /**
+     * @brief 按照 format 输出参数，format 中的 {} 依次被参数替换，多余的参数以空格分隔追加在末尾
+     */
+    template <typename Stream, typename... Args>
+    void formatLogSite(Stream &stream, const char *format, const Args &...args)
+    {
+        const char *p = format;
+        [[maybe_unused]] auto formatArg = [&stream, &p](const auto &arg) {
+            const char *placeholder = strstr(p, "{}");
+            if (placeholder)
+            {
+                stream << std::string_view(p, static_cast<size_t>(placeholder - p)) << arg;
+                p = placeholder + 2;
+            }
+            else
+            {
+                stream << std::string_view(p) << ' ' << arg;
+                p += strlen(p);
+            }
+        };
+        (formatArg(args), ...);
+        stream << std::string_view(p);
+    }
+
+    /**
+     * @brief 后端线程调用，依次解码参数并格式化。花括号初始化保证参数按从左到右的顺序解码
+     */
+    template <typename... Args>
+    void decodeLogArgs([[maybe_unused]] const char *args, LogContext &context, const char *format)
+    {
+        std::tuple<typename LogArg<Args>::Decoded...> values{LogArg<Args>::decode(args)...};
+        std::apply([&context, format](const auto &...decoded) { formatLogSite(context, format, decoded...); }, values);
+    }
+
+    template <typename... Args>
+    void logBinary(const LogSite &site, const Args &...args)
+    {
+        Logger &logger = Logger::instance();
+        AsyncLogging *asyncLogger = logger.asyncLogger();
+        size_t size = (static_cast<size_t>(0) + ... + LogArg<std::decay_t<Args>>::size(args));
+        if (asyncLogger && site.logLevel != LogLevel::FATAL && size <= LogBinaryMaxArgsSize)
+        {
+            char buffer[LogBinaryMaxArgsSize];
+            [[maybe_unused]] char *p = buffer;
+            (LogArg<std::decay_t<Args>>::encode(p, args), ...);
+            asyncLogger->appendBinary(site, &decodeLogArgs<std::decay_t<Args>...>, buffer, size);
+        }
+        else
+        {
+            LogRecorder recorder(site.sourceFilename, site.funcname, site.line, site.logLevel, logger);
+            formatLogSite(recorder, site.format, logArgValue(args)...);
+        }
+    }
+
+/**
+ * LogSite 由常量初始化，调用点不需要静态局部变量的初始化检查
+ */
+#define LOG_BINARY(LEVEL, FORMAT, ...)                                                             \
+    do                                                                                             \
+    {                                                                                              \
+        if ((LEVEL) >= STNL_LOG_MIN_LEVEL && (LEVEL) >= Logger::logLevel())                        \
+        {                                                                                          \
+            static const LogSite stnlLogSite = {__FILE__, __FUNCTION__, __LINE__, LEVEL, FORMAT};  \
+            logBinary(stnlLogSite, ##__VA_ARGS__);                                                 \
+        }                                                                                          \
+    } while (0)
+
+#define LOG_BINARY_TRACE(FORMAT, ...) LOG_BINARY(LogLevel::TRACE, FORMAT, ##__VA_ARGS__)
+#define LOG_BINARY_DEBUG(FORMAT, ...) LOG_BINARY(LogLevel::DEBUG, FORMAT, ##__VA_ARGS__)
+#define LOG_BINARY_INFO(FORMAT, ...) LOG_BINARY(LogLevel::INFO, FORMAT, ##__VA_ARGS__)
+#define LOG_BINARY_WARN(FORMAT, ...) LOG_BINARY(LogLevel::WARN, FORMAT, ##__VA_ARGS__)
+#define LOG_BINARY_ERROR(FORMAT, ...) LOG_BINARY(LogLevel::ERROR, FORMAT, ##__VA_ARGS__)
+#define LOG_BINARY_FATAL(FORMAT, ...) LOG_BINARY(LogLevel::FATAL, FORMAT, ##__VA_ARGS__)
+
+} // namespace stnl
+
+#endif
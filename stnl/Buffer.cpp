@@ -1,27 +1,101 @@
 #include "Buffer.h"
 
+#include <algorithm>
+
 using namespace stnl;
 
 
 
 const size_t NetBuffer::ReservedPrependSize;
 const size_t NetBuffer::InitialBufferSize;
+const size_t NetBuffer::MaxReadSizeHint;
+char NetBuffer::EmptyStorage[NetBuffer::ReservedPrependSize];
+
+namespace
+{
+    /**
+     * 每个线程（one loop per thread，即每个 EventLoop）共享一块溢出缓冲区，
+     * 代替每次 readFD 调用都在栈上放置 64KB 的 extrabuf。
+     *
+     * 若某次读取把溢出缓冲区也填满了，说明 socket 上还有更多数据，将其扩大一倍（不超过 MaxSize）；
+     * 若连续很多次读取都只用到了很小的一部分，则缩小一半，把内存还回去。
+     */
+    class ExtraBuffer
+    {
+    public:
+        static const size_t MinSize = 64 * 1024;        // 64KB
+        static const size_t MaxSize = 1024 * 1024;      // 1MB
+        static const int ShrinkAfterReads = 1024;
+
+        ExtraBuffer() : data_(new char[MinSize]), size_(MinSize), smallReads_(0) {}
+
+        char *data() { return data_.get(); }
+
+        size_t size() const { return size_; }
+
+        /**
+         * 根据本次溢出到该缓冲区的字节数调整大小
+         */
+        void adjust(size_t used)
+        {
+            if (used == size_ && size_ < MaxSize)
+            {
+                resize(size_ * 2);
+            }
+            else if (used < size_ / 4 && size_ > MinSize)
+            {
+                if (++smallReads_ >= ShrinkAfterReads)
+                {
+                    resize(size_ / 2);
+                }
+            }
+            else
+            {
+                smallReads_ = 0;
+            }
+        }
+
+    private:
+        void resize(size_t size)
+        {
+            data_.reset(new char[size]);
+            size_ = size;
+            smallReads_ = 0;
+        }
+
+        std::unique_ptr<char[]> data_;
+        size_t size_;
+        int smallReads_;
+    };
+
+    thread_local ExtraBuffer t_extraBuffer;
+}
 
 ssize_t NetBuffer::readFD(int fd, int *savedErrno)
 {
-    char extrabuf[65536]; // 64KB
+    /*
+        根据最近几次的读取量预留可写空间，让大多数情况下的数据直接读入 buffer_ 中，
+        只有突发的大块数据才会溢出到 extrabuf，再经 append 拷贝一次。
+    */
+    if (writeableBytes() < readSizeHint_)
+    {
+        makeSpace(readSizeHint_);
+    }
+
+    char *extrabuf = t_extraBuffer.data();
+    const size_t extrabufSize = t_extraBuffer.size();
     struct iovec vec[2];
     const size_t writeable = writeableBytes();
     vec[0].iov_base = writeIndex();
     vec[0].iov_len = writeable;
     vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof(extrabuf);
+    vec[1].iov_len = extrabufSize;
 
     /*
         详情见陈硕的《多线程服务器编程》p315 脚注部分。
         “64KB的buffer足够容纳千兆网在500us内全速收到的数据”
     */
-    const int vec_size = writeable < sizeof(extrabuf) ? 2 : 1;
+    const int vec_size = writeable < extrabufSize ? 2 : 1;
     ssize_t n = readv(fd, vec, vec_size);
 
     // NOTE: 使用C++中的异常处理
@@ -29,25 +103,54 @@ ssize_t NetBuffer::readFD(int fd, int *savedErrno)
     {
         *savedErrno = errno;
     }
-    else if (static_cast<size_t>(n) < writeable)
+    else if (n == 0)
+    {
+        // 对端关闭，把刚借用的内存还回去
+        if (pool_ && readableBytes() == 0)
+        {
+            releaseStorage();
+        }
+    }
+    else if (static_cast<size_t>(n) <= writeable)
     {
         // buffer_中的可写空间足够
         writeIndex_ += n;
+        if (vec_size == 2)
+        {
+            t_extraBuffer.adjust(0);
+        }
     }
     else
     {
         // buffer_中空间不够写，需要额外的空间
-        writeIndex_ = buffer_.size();
+        writeIndex_ = capacity_;
         append(extrabuf, n - writeable);
+        t_extraBuffer.adjust(n - writeable);
+    }
+
+    if (n > 0)
+    {
+        updateReadSizeHint(static_cast<size_t>(n));
     }
-    /**
-     * FIXME: if (n == writeable + sizeof(extrabuf))
-     * 说明文件描述符上缓冲区中的数据调用一次readv不能全部读出
-    */
 
     return n;
 }
 
+void NetBuffer::updateReadSizeHint(size_t n)
+{
+    if (n > readSizeHint_)
+    {
+        // 快速增长：直接增长到能容纳本次读取量
+        readSizeHint_ = std::min(std::max(n, readSizeHint_ * 2), MaxReadSizeHint);
+    }
+    else
+    {
+        // 缓慢回落：每次向本次读取量靠近 1/8
+        readSizeHint_ -= (readSizeHint_ - n) / 8;
+        readSizeHint_ = std::max(readSizeHint_, InitialBufferSize);
+    }
+}
+
 void NetBuffer::memoryMoving()
 {
     assert(ReservedPrependSize < readIndex_);
@@ -58,32 +161,76 @@ void NetBuffer::memoryMoving()
     assert(readable == readableBytes());
 }
 
-void NetBuffer::append(const char *buf, size_t len)
+void NetBuffer::allocateStorage(size_t size)
 {
-    if (len <= writeableBytes())
+    if (pool_)
+    {
+        buffer_ = pool_->allocate(size, &capacity_);
+    }
+    else
+    {
+        buffer_ = static_cast<char *>(::operator new(size));
+        capacity_ = size;
+    }
+}
+
+void NetBuffer::releaseStorage()
+{
+    if (!hasStorage())
+    {
+        return;
+    }
+
+    if (pool_)
     {
-        std::copy(buf, buf + len, writeIndex());
+        pool_->deallocate(buffer_, capacity_);
     }
     else
     {
-        if (len <= writeableBytes() + prependableBytes() - ReservedPrependSize)
+        ::operator delete(buffer_);
+    }
+    buffer_ = EmptyStorage;
+    capacity_ = ReservedPrependSize;
+}
+
+void NetBuffer::makeSpace(size_t len)
+{
+    if (hasStorage() && len <= writeableBytes() + prependableBytes() - ReservedPrependSize)
+    {
+        /*
+            buffer 末端的连续可写空间不足，但总的可写空间大于 len。
+            将buffer中的已写空间向前挪动
+        */
+        memoryMoving();
+        return;
+    }
+
+    /*
+        buffer总的可写空间不足小于 len。
+        先分配更大的内存（按 2 倍增长，且新分配的内存不做初始化），然后再把数据挪动到新内存的前头。
+    */
+    size_t readable = readableBytes();
+    char *oldBuffer = buffer_;
+    size_t oldCapacity = capacity_;
+    size_t newCapacity = ReservedPrependSize + readable + len;
+    if (hasStorage())
+    {
+        newCapacity = std::max(newCapacity, capacity_ * 2);
+    }
+    allocateStorage(newCapacity);
+    std::copy(oldBuffer + readIndex_, oldBuffer + writeIndex_, buffer_ + ReservedPrependSize);
+    readIndex_ = ReservedPrependSize;
+    writeIndex_ = readIndex_ + readable;
+
+    if (oldBuffer != EmptyStorage)
+    {
+        if (pool_)
         {
-            /*
-                buffer 末端的连续可写空间不足，但总的可写空间大于 len。
-                将buffer中的已写空间向前挪动
-            */
-            memoryMoving();
+            pool_->deallocate(oldBuffer, oldCapacity);
         }
         else
         {
-            // @todo: 需要进行性能优化
-            /*
-                buffer总的可写空间不足小于 len。
-                先分配更大的内存，然后再挪动位置。
-            */
-            buffer_.resize(writeIndex_ + len);
+            ::operator delete(oldBuffer);
         }
-        std::copy(buf, buf + len, writeIndex());
     }
-    writeIndex_ += len;
-}
\ No newline at end of file
+}
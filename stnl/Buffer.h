@@ -11,6 +11,7 @@
 #include <sys/uio.h>
 
 #include "noncopyable.h"
+#include "BufferPool.h"
 
 namespace stnl
 {
@@ -65,24 +66,24 @@ namespace stnl
             return curIndex_;
         }
 
-        void append(const char *data, std::size_t len)
+        /**
+         * @brief 写入 len 字节的数据。剩余空间不足时不写入任何数据并返回 false，
+         * 由调用者决定如何处理（例如先写出当前 buffer 再重试，或直接写出这条数据）。
+         */
+        bool append(const char *data, std::size_t len)
         {
-            if (remainingCapacity() > len)
+            if (static_cast<std::size_t>(remainingCapacity()) < len)
             {
-                memcpy(curIndex_, data, len);
-                curIndex_ += len;
+                return false;
             }
-            // FIXME: 若缓冲区可用大小小于写入的字节数量，如何处理？
+            memcpy(curIndex_, data, len);
+            curIndex_ += len;
+            return true;
         }
 
-        void append(std::string_view str)
+        bool append(std::string_view str)
         {
-            if (remainingCapacity() > str.size())
-            {
-                memcpy(curIndex_, str.data(), str.size());
-                curIndex_ += str.size();
-            }
-            // FIXME: 若缓冲区可用大小小于写入的字节数量，如何处理？
+            return append(str.data(), str.size());
         }
 
         void add(int len)
@@ -90,9 +91,11 @@ namespace stnl
             curIndex_ += len;
         }
 
+        /**
+         * @brief 清空 buffer。只重置写入位置，已写入的内存不需要清零
+         */
         void clear()
         {
-            memset(begin(), 0, capacity_);
             curIndex_ = buffer_.get();
         }
 
@@ -119,37 +122,63 @@ namespace stnl
      *
      * prependableBytes = readIndex
      * readableBytes = writeIndex - readIndex
-     * writeableBytes = buffer.size() - writeIndex
+     * writeableBytes = capacity - writeIndex
      *
+     * 若构造时传入了 BufferPool，则 buffer 的内存从池中借用，并且在数据被读空时立即归还，
+     * 此时空的 buffer 不占用任何内存。
      */
     class NetBuffer : public noncopyable
     {
     public:
         static const size_t ReservedPrependSize = 8;
         static const size_t InitialBufferSize = 1024; // 1kB
+        /* 预留的空间加上 prepend 区域恰好是 BufferPool 中最大的内存块，读满 hint 的 buffer 仍然从池中借用内存 */
+        static const size_t MaxReadSizeHint = BufferPool::MaxChunkSize - ReservedPrependSize;
 
-        explicit NetBuffer(size_t initialBufferSize = InitialBufferSize) : buffer_(ReservedPrependSize + initialBufferSize),
+        explicit NetBuffer(size_t initialBufferSize = InitialBufferSize) : buffer_(nullptr),
+                                                                           capacity_(0),
                                                                            readIndex_(ReservedPrependSize),
-                                                                           writeIndex_(ReservedPrependSize)
+                                                                           writeIndex_(ReservedPrependSize),
+                                                                           readSizeHint_(InitialBufferSize)
         {
+            allocateStorage(ReservedPrependSize + initialBufferSize);
             assert(readableBytes() == 0);
             assert(writeableBytes() == initialBufferSize);
             assert(prependableBytes() == ReservedPrependSize);
         }
 
+        /**
+         * 从 pool 中按需借用内存，数据被读空后归还。
+         */
+        explicit NetBuffer(std::shared_ptr<BufferPool> pool) : buffer_(EmptyStorage),
+                                                               capacity_(ReservedPrependSize),
+                                                               readIndex_(ReservedPrependSize),
+                                                               writeIndex_(ReservedPrependSize),
+                                                               readSizeHint_(InitialBufferSize),
+                                                               pool_(std::move(pool))
+        {
+            assert(readableBytes() == 0);
+            assert(writeableBytes() == 0);
+        }
+
+        ~NetBuffer()
+        {
+            releaseStorage();
+        }
+
         size_t capacity() const
         {
-            return buffer_.capacity();
+            return capacity_;
         }
 
         char *begin()
         {
-            return &*buffer_.begin();
+            return buffer_;
         }
 
         const char *begin() const
         {
-            return &*buffer_.begin();
+            return buffer_;
         }
 
         size_t readableBytes() const
@@ -159,7 +188,7 @@ namespace stnl
 
         size_t writeableBytes() const
         {
-            return buffer_.size() - writeIndex_;
+            return capacity_ - writeIndex_;
         }
 
         size_t prependableBytes() const
@@ -192,7 +221,39 @@ namespace stnl
             return begin() + readIndex_;
         }
 
-        void append(const char *buf, size_t len);
+        /**
+         * 是否持有内存。借用 BufferPool 的 buffer 在数据被读空后不持有内存。
+         */
+        bool hasStorage() const
+        {
+            return buffer_ != EmptyStorage;
+        }
+
+        /**
+         * 保证至少有 len 字节的连续可写空间，之后可以直接向 writeIndex() 写入数据，
+         * 写完后调用 hasWritten() 提交。
+         */
+        void ensureWritable(size_t len)
+        {
+            if (len > writeableBytes())
+            {
+                makeSpace(len);
+            }
+            assert(len <= writeableBytes());
+        }
+
+        void hasWritten(size_t len)
+        {
+            assert(len <= writeableBytes());
+            writeIndex_ += len;
+        }
+
+        void append(const char *buf, size_t len)
+        {
+            ensureWritable(len);
+            std::copy(buf, buf + len, writeIndex());
+            hasWritten(len);
+        }
 
         void append(const void *buf, size_t len)
         {
@@ -210,6 +271,10 @@ namespace stnl
         void prepend(const void *buf, size_t len)
         {
             assert(len <= prependableBytes());
+            if (!hasStorage())
+            {
+                makeSpace(0);
+            }
             readIndex_ -= len;
             const char *data = static_cast<const char *>(buf);
             std::copy(data, data + len, begin() + readIndex_);
@@ -252,6 +317,11 @@ namespace stnl
         {
             readIndex_ = ReservedPrependSize;
             writeIndex_ = ReservedPrependSize;
+            if (pool_ && hasStorage())
+            {
+                // 数据已被读空，把内存归还给 pool
+                releaseStorage();
+            }
         }
 
         /**
@@ -261,23 +331,14 @@ namespace stnl
         {
             assert(len <= readableBytes());
             std::string res(peek(), len);
-            if (len < readableBytes())
-            {
-                readIndex_ += len;
-            }
-            else
-            {
-                readIndex_ = ReservedPrependSize;
-                writeIndex_ = ReservedPrependSize;
-            }
+            retrieve(len);
             return res;
         }
 
         std::string retrieveAllAsString()
         {
             std::string res(peek(), readableBytes());
-            readIndex_ = ReservedPrependSize;
-            writeIndex_ = ReservedPrependSize;
+            retrieveAll();
             return res;
         }
 
@@ -286,17 +347,43 @@ namespace stnl
          */
         ssize_t readFD(int fd, int *savedErrno);
 
+        /**
+         * readFD 在读取前预留的可写空间大小，根据最近的读取量自适应调整
+         */
+        size_t readSizeHint() const
+        {
+            return readSizeHint_;
+        }
+
     private:
         /**
          * 把已有的数据移动到buffer的前头，腾出 writeable 的空间。
          * 一种优化的方法是，使用 circular buffer，但是这样buffer中的数据存放就不是"连续的"。
+         * 见 RingBuffer。
          */
         void memoryMoving();
 
+        /**
+         * 保证至少有 len 字节的可写空间。空间不足时容量至少翻倍，避免连续的小块写入反复重新分配。
+         */
+        void makeSpace(size_t len);
+
+        void allocateStorage(size_t size);
+
+        void updateReadSizeHint(size_t n);
+
+        void releaseStorage();
+
     private:
-        std::vector<char> buffer_;
+        /* 不持有内存时 buffer_ 指向该区域，保证 peek() 等接口返回的指针合法 */
+        static char EmptyStorage[ReservedPrependSize];
+
+        char *buffer_;
+        size_t capacity_;
         size_t readIndex_;
         size_t writeIndex_;
+        size_t readSizeHint_;
+        std::shared_ptr<BufferPool> pool_;
     };
 
 }
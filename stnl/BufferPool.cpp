@@ -0,0 +1,107 @@
+#include "BufferPool.h"
+
+#include <new>
+#include <algorithm>
+
+using namespace stnl;
+
+const size_t BufferPool::SizeClasses[BufferPool::NumSizeClasses] = {
+    4 * 1024,
+    16 * 1024,
+    MaxChunkSize,
+};
+
+const size_t BufferPool::MaxChunkSize;
+const size_t BufferPool::MaxCachedBytesPerClass;
+
+BufferPool::BufferPool() : tid_(std::this_thread::get_id())
+{
+    for (int i = 0; i < NumSizeClasses; ++i)
+    {
+        minFreeCount_[i] = 0;
+    }
+}
+
+BufferPool::~BufferPool()
+{
+    for (auto &chunks : freeChunks_)
+    {
+        for (char *chunk : chunks)
+        {
+            ::operator delete(chunk);
+        }
+    }
+}
+
+int BufferPool::sizeClassIndex(size_t size)
+{
+    for (int i = 0; i < NumSizeClasses; ++i)
+    {
+        if (size <= SizeClasses[i])
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+char *BufferPool::allocate(size_t size, size_t *chunkSize)
+{
+    int index = sizeClassIndex(size);
+    if (index < 0)
+    {
+        // 超出最大的大小类别，直接在堆上分配
+        *chunkSize = size;
+        return static_cast<char *>(::operator new(size));
+    }
+
+    *chunkSize = SizeClasses[index];
+    if (isInOwnerThread() && !freeChunks_[index].empty())
+    {
+        char *chunk = freeChunks_[index].back();
+        freeChunks_[index].pop_back();
+        minFreeCount_[index] = std::min(minFreeCount_[index], freeChunks_[index].size());
+        return chunk;
+    }
+
+    return static_cast<char *>(::operator new(*chunkSize));
+}
+
+void BufferPool::deallocate(char *chunk, size_t chunkSize)
+{
+    int index = sizeClassIndex(chunkSize);
+    if (index >= 0 && SizeClasses[index] == chunkSize && isInOwnerThread() &&
+        (freeChunks_[index].size() + 1) * chunkSize <= MaxCachedBytesPerClass)
+    {
+        freeChunks_[index].push_back(chunk);
+        return;
+    }
+
+    ::operator delete(chunk);
+}
+
+void BufferPool::shrink()
+{
+    for (int i = 0; i < NumSizeClasses; ++i)
+    {
+        auto &chunks = freeChunks_[i];
+        size_t n = std::min(minFreeCount_[i], chunks.size());
+        for (size_t j = 0; j < n; ++j)
+        {
+            ::operator delete(chunks.back());
+            chunks.pop_back();
+        }
+        chunks.shrink_to_fit();
+        minFreeCount_[i] = chunks.size();
+    }
+}
+
+size_t BufferPool::cachedBytes() const
+{
+    size_t bytes = 0;
+    for (int i = 0; i < NumSizeClasses; ++i)
+    {
+        bytes += freeChunks_[i].size() * SizeClasses[i];
+    }
+    return bytes;
+}
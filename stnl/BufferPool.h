@@ -0,0 +1,73 @@
+#ifndef STNL_BUFFERPOOL_H
+#define STNL_BUFFERPOOL_H
+
+#include <vector>
+#include <thread>
+#include <cstddef>
+
+#include "noncopyable.h"
+
+namespace stnl
+{
+
+    /**
+     * @brief 每个 EventLoop 拥有一个 BufferPool，为 NetBuffer 提供固定大小的内存块。
+     *
+     * 内存块按 4KB/16KB/64KB 分为三个大小类别，每个类别维护一个空闲列表（std::vector）。
+     * NetBuffer 在需要时从池中借用内存块，数据被读空后立即归还，
+     * 因此大量空闲连接不会各自占着两块缓冲区。
+     *
+     * 池是单线程的：空闲列表没有任何同步，只在所属的 loop 线程中复用内存块；
+     * 在其他线程中调用 allocate/deallocate 时不访问空闲列表，直接退化为堆上的分配与释放。
+     * shrink() 与 cachedBytes() 只能在所属的 loop 线程中调用。
+     */
+    class BufferPool : public noncopyable
+    {
+    public:
+        static const int NumSizeClasses = 3;
+        static const size_t SizeClasses[NumSizeClasses];
+        static const size_t MaxChunkSize = 64 * 1024; // 最大的大小类别，64KB
+        static const size_t MaxCachedBytesPerClass = 4 * 1024 * 1024; // 4MB
+
+        BufferPool();
+
+        ~BufferPool();
+
+        /**
+         * @brief 分配至少 size 字节的内存块
+         *
+         * @param size 需要的大小
+         * @param chunkSize 返回实际分配的大小，归还时需要原样传回
+         * @return char*
+         */
+        char *allocate(size_t size, size_t *chunkSize);
+
+        void deallocate(char *chunk, size_t chunkSize);
+
+        /**
+         * @brief 释放自上一次 shrink 以来一直没有被借出过的空闲内存块。
+         * 由 EventLoop 在空闲时调用。
+         */
+        void shrink();
+
+        /**
+         * @brief 池中缓存的空闲内存的总字节数
+         */
+        size_t cachedBytes() const;
+
+        bool isInOwnerThread() const { return tid_ == std::this_thread::get_id(); }
+
+    private:
+        static int sizeClassIndex(size_t size);
+
+    private:
+        const std::thread::id tid_;
+        std::vector<char *> freeChunks_[NumSizeClasses];
+
+        /* 自上一次 shrink 以来，每个空闲列表长度的最小值，即一直未被使用的内存块数量 */
+        size_t minFreeCount_[NumSizeClasses];
+    };
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+#include "Coroutine.h"
+#include "logger.h"
+
+#include <new>
+
+using namespace stnl;
+
+const std::size_t FrameAllocator::Alignment;
+const std::size_t FrameAllocator::MaxFrameSize;
+const std::size_t FrameAllocator::NumSizeClasses;
+const std::size_t FrameAllocator::MaxCachedFramesPerClass;
+
+FrameAllocator::FrameAllocator() : heapAllocations_(0)
+{
+    for (std::size_t i = 0; i < NumSizeClasses; ++i)
+    {
+        freeLists_[i] = nullptr;
+        freeCounts_[i] = 0;
+    }
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    for (std::size_t i = 0; i < NumSizeClasses; ++i)
+    {
+        while (freeLists_[i])
+        {
+            FreeFrame *frame = freeLists_[i];
+            freeLists_[i] = frame->next;
+            ::operator delete(frame);
+        }
+    }
+}
+
+FrameAllocator &FrameAllocator::instance()
+{
+    thread_local FrameAllocator t_allocator;
+    return t_allocator;
+}
+
+void *FrameAllocator::allocate(std::size_t size)
+{
+    FrameAllocator &allocator = instance();
+    if (size > MaxFrameSize)
+    {
+        ++allocator.heapAllocations_;
+        return ::operator new(size);
+    }
+
+    std::size_t index = (size - 1) / Alignment;
+    FreeFrame *frame = allocator.freeLists_[index];
+    if (frame)
+    {
+        allocator.freeLists_[index] = frame->next;
+        --allocator.freeCounts_[index];
+        return frame;
+    }
+
+    ++allocator.heapAllocations_;
+    return ::operator new((index + 1) * Alignment);
+}
+
+void FrameAllocator::deallocate(void *frame, std::size_t size)
+{
+    FrameAllocator &allocator = instance();
+    std::size_t index = (size - 1) / Alignment;
+    if (size > MaxFrameSize || allocator.freeCounts_[index] >= MaxCachedFramesPerClass)
+    {
+        ::operator delete(frame);
+        return;
+    }
+
+    FreeFrame *freeFrame = static_cast<FreeFrame *>(frame);
+    freeFrame->next = allocator.freeLists_[index];
+    allocator.freeLists_[index] = freeFrame;
+    ++allocator.freeCounts_[index];
+}
+
+std::size_t FrameAllocator::heapAllocations()
+{
+    return instance().heapAllocations_;
+}
+
+void detail::PromiseBase::unhandled_exception()
+{
+    if (!detached_)
+    {
+        exception_ = std::current_exception();
+        return;
+    }
+
+    try
+    {
+        throw;
+    }
+    catch (const std::exception &e)
+    {
+        LOG_FATAL << "detached coroutine exited with exception: " << e.what();
+    }
+    catch (...)
+    {
+        LOG_FATAL << "detached coroutine exited with unknown exception";
+    }
+}
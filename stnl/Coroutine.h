@@ -0,0 +1,281 @@
+#ifndef STNL_COROUTINE_H
+#define STNL_COROUTINE_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+
+#include "noncopyable.h"
+
+/**
+ * C++20 协程支持。
+ *
+ * 协程运行在 EventLoop 所在的线程中，由 TcpConnection、EventLoop、TcpClient 提供的 awaitable
+ * 挂起，并在 loop 线程中的事件回调里被直接恢复（resume），不经过 std::function 与 queueInLoop。
+ *
+ *   Task<> session(TcpConnection::TcpConnectionPtr conn)
+ *   {
+ *       while (conn->isConnected())
+ *       {
+ *           std::string header = co_await conn->read(4);
+ *           ...
+ *           co_await conn->write(response);
+ *       }
+ *   }
+ *
+ *   // 在 ConnectionCallback 中启动
+ *   session(conn).detach();
+ */
+
+namespace stnl
+{
+
+    template <typename T = void>
+    class Task;
+
+    /**
+     * @brief 协程帧的内存分配器，每个线程（即每个 EventLoop）一个实例。
+     *
+     * 协程帧按 64 字节对齐分为若干大小类别，每个类别维护一个侵入式的空闲链表，
+     * 释放的协程帧挂回链表供下一次复用。协程只在所属的 loop 线程中创建和销毁，因此不需要加锁。
+     * 稳态下"每个请求一个协程"不会产生堆内存分配。
+     */
+    class FrameAllocator : public noncopyable
+    {
+    public:
+        static const std::size_t Alignment = 64;
+        static const std::size_t MaxFrameSize = 4096;
+        static const std::size_t NumSizeClasses = MaxFrameSize / Alignment;
+        static const std::size_t MaxCachedFramesPerClass = 1024;
+
+        static void *allocate(std::size_t size);
+
+        static void deallocate(void *frame, std::size_t size);
+
+        /**
+         * 当前线程中从堆上分配协程帧的次数
+         */
+        static std::size_t heapAllocations();
+
+    private:
+        struct FreeFrame
+        {
+            FreeFrame *next;
+        };
+
+        FrameAllocator();
+
+        ~FrameAllocator();
+
+        static FrameAllocator &instance();
+
+    private:
+        FreeFrame *freeLists_[NumSizeClasses];
+        std::size_t freeCounts_[NumSizeClasses];
+        std::size_t heapAllocations_;
+    };
+
+    namespace detail
+    {
+        class PromiseBase
+        {
+        public:
+            /* 协程帧从当前线程的 FrameAllocator 中分配 */
+            static void *operator new(std::size_t size)
+            {
+                return FrameAllocator::allocate(size);
+            }
+
+            static void operator delete(void *frame, std::size_t size)
+            {
+                FrameAllocator::deallocate(frame, size);
+            }
+
+            /**
+             * 协程执行完毕时，若有等待者（co_await 该 Task 的协程）则直接切换过去（对称转移），
+             * 若已 detach 则销毁自身的协程帧。
+             */
+            struct FinalAwaiter
+            {
+                bool await_ready() const noexcept { return false; }
+
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+                {
+                    PromiseBase &promise = handle.promise();
+                    if (promise.continuation_)
+                    {
+                        return promise.continuation_;
+                    }
+                    if (promise.detached_)
+                    {
+                        handle.destroy();
+                    }
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            /* Task 是惰性启动的，由 co_await 或 detach() 开始执行 */
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+
+            /**
+             * 异常保存下来，在等待者 co_await 得到结果时重新抛出。
+             * detach 的协程没有等待者可以接收异常，记录日志后终止进程，
+             * 而不是把异常抛进恢复它的 EventLoop 回调中。
+             */
+            void unhandled_exception();
+
+            void setContinuation(std::coroutine_handle<> continuation) { continuation_ = continuation; }
+
+            void setDetached() { detached_ = true; }
+
+        protected:
+            void rethrowIfException()
+            {
+                if (exception_)
+                {
+                    std::rethrow_exception(exception_);
+                }
+            }
+
+        private:
+            std::coroutine_handle<> continuation_;
+            bool detached_ = false;
+            std::exception_ptr exception_;
+        };
+
+        template <typename T>
+        class Promise : public PromiseBase
+        {
+        public:
+            Task<T> get_return_object();
+
+            template <typename U>
+            void return_value(U &&value)
+            {
+                value_.emplace(std::forward<U>(value));
+            }
+
+            T result()
+            {
+                rethrowIfException();
+                return std::move(*value_);
+            }
+
+        private:
+            std::optional<T> value_;
+        };
+
+        template <>
+        class Promise<void> : public PromiseBase
+        {
+        public:
+            Task<void> get_return_object();
+
+            void return_void() {}
+
+            void result()
+            {
+                rethrowIfException();
+            }
+        };
+    }
+
+    /**
+     * @brief 协程的返回类型
+     *
+     * 可以在另一个协程中 co_await，获取其返回值；
+     * 也可以调用 detach() 启动一个独立运行的协程，协程结束后自动释放协程帧。
+     */
+    template <typename T>
+    class [[nodiscard]] Task : public noncopyable
+    {
+    public:
+        using promise_type = detail::Promise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        explicit Task(Handle handle) : handle_(handle) {}
+
+        Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+        Task &operator=(Task &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle_)
+                {
+                    handle_.destroy();
+                }
+                handle_ = std::exchange(other.handle_, nullptr);
+            }
+            return *this;
+        }
+
+        ~Task()
+        {
+            if (handle_)
+            {
+                handle_.destroy();
+            }
+        }
+
+        bool done() const { return !handle_ || handle_.done(); }
+
+        /**
+         * 在当前线程中立即开始执行协程，协程帧的生命周期由协程自己管理。
+         */
+        void detach()
+        {
+            assert(handle_);
+            Handle handle = std::exchange(handle_, nullptr);
+            handle.promise().setDetached();
+            handle.resume();
+        }
+
+        auto operator co_await() && noexcept
+        {
+            struct Awaiter
+            {
+                Handle handle_;
+
+                bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+                {
+                    handle_.promise().setContinuation(awaiting);
+                    return handle_;
+                }
+
+                T await_resume() { return handle_.promise().result(); }
+            };
+            return Awaiter{handle_};
+        }
+
+    private:
+        Handle handle_;
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        inline Task<T> Promise<T>::get_return_object()
+        {
+            return Task<T>(Task<T>::Handle::from_promise(*this));
+        }
+
+        inline Task<void> Promise<void>::get_return_object()
+        {
+            return Task<void>(Task<void>::Handle::from_promise(*this));
+        }
+    }
+
+}
+
+#endif
@@ -2,17 +2,33 @@
 #include "Epoll.h"
 #include "Channel.h"
 #include <cassert>
+#include <algorithm>
 #include <sys/eventfd.h>
 #include <thread>
 #include "logger.h"
 #include <unistd.h>
 #include "Timer.h"
+#include "BufferPool.h"
+#include "SpscQueue.h"
 
 
 namespace stnl
 {
     thread_local EventLoop *loopInCurrentThread = nullptr;
 
+    /**
+     * 一对 loop 之间的单向通道，生产者 loop 写入，消费者 loop 在 doPendingFunctions 中取出执行。
+     * 两端各持有一份 shared_ptr，任意一端析构时通过标志位通知另一端。
+     */
+    struct EventLoop::LoopChannel
+    {
+        SpscQueue<EventLoop::PendingFunction> functions;
+        std::atomic_bool producerAlive{true};
+        std::atomic_bool consumerAlive{true};
+    };
+
+    const size_t EventLoop::MaxFunctionsPerChannel;
+
     int createEventfd()
     {
         int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
@@ -24,13 +40,27 @@ namespace stnl
     }
 
     // FIXME: tid_初始化
-    EventLoop::EventLoop() : looping_(false), running_(false),
-                             tid_(std::this_thread::get_id()),
+    EventLoop::EventLoop() : tid_(std::this_thread::get_id()),
                              selector_(new Epoll(this)),
+                             looping_(false),
+                             running_(false),
+                             timerQueue_(new TimerQueue(this)),
+                             bufferPool_(std::make_shared<BufferPool>()),
                              wakeupFd_(createEventfd()),
                              wakeupChannel_(new Channel(this, wakeupFd_)),
                              callingPendingFunctions_(false),
-                             timerQueue_(new TimerQueue(this))
+                             pendingCount_(0),
+                             pendingCapacity_(0),
+                             overflowPolicy_(OverflowPolicy::Reject),
+                             rejectedCount_(0),
+                             droppedCount_(0),
+                             blockedProducers_(0),
+                             quitRequested_(false),
+                             dropBudget_(0),
+                             pendingTimeBudget_(0),
+                             busyPollDuration_(0),
+                             inChannelsChanged_(false),
+                             channelWakeupPending_(false)
     {
         LOG_DEBUG << "EventLoop created.";
 
@@ -53,6 +83,19 @@ namespace stnl
         wakeupChannel_->disableAll();
         wakeupChannel_->remove();
         ::close(wakeupFd_);
+
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            for (auto &channel : inChannels_)
+            {
+                channel->consumerAlive = false;
+            }
+        }
+        for (auto &item : outChannels_)
+        {
+            item.second->producerAlive = false;
+        }
+
         loopInCurrentThread = nullptr;
     }
 
@@ -63,22 +106,207 @@ namespace stnl
 
     void EventLoop::doPendingFunctions()
     {
-        std::vector<Func> functions;
+        std::vector<PendingFunction> functions;
         callingPendingFunctions_ = true;
+        auto start = std::chrono::steady_clock::now();
+
+        // 先清除标志再取任务，此后写入通道的任务会再次唤醒本 loop
+        channelWakeupPending_ = false;
+
+        // DropOldest：入队时已经丢弃了大部分超出容量的任务，
+        // 剩余超出的部分（可丢弃的任务都已被 loop 取出时）从最早取出的可丢弃任务开始丢弃
+        size_t capacity = pendingCapacity_;
+        size_t pending = pendingCount_;
+        dropBudget_ = 0;
+        if (capacity > 0 && overflowPolicy_ == OverflowPolicy::DropOldest && pending > capacity)
+        {
+            dropBudget_ = pending - capacity;
+        }
 
         {
             std::unique_lock<std::mutex> locker(mutex_);
             functions.swap(pendingFunctions_);
+            if (!sheddableFunctions_.empty())
+            {
+                functions.insert(functions.end(),
+                                 std::make_move_iterator(sheddableFunctions_.begin()),
+                                 std::make_move_iterator(sheddableFunctions_.end()));
+                sheddableFunctions_.clear();
+            }
+        }
+        for (auto &function : functions)
+        {
+            collectFunction(function);
         }
+        collectChannelFunctions();
 
-        for (auto &func : functions)
+        for (auto &function : controlFunctions_)
         {
-            func();
+            runPendingFunction(function);
         }
+        releasePending(controlFunctions_.size());
+        controlFunctions_.clear();
+
+        for (auto &function : criticalFunctions_)
+        {
+            runPendingFunction(function);
+        }
+        releasePending(criticalFunctions_.size());
+        criticalFunctions_.clear();
+
+        releasePending(runBackgroundFunctions(start));
 
         callingPendingFunctions_ = false;
     }
 
+    void EventLoop::collectFunction(PendingFunction &function)
+    {
+        switch (function.priority)
+        {
+        case Priority::Control:
+            controlFunctions_.emplace_back(std::move(function));
+            break;
+        case Priority::Background:
+            backgroundFunctions_.emplace_back(std::move(function));
+            break;
+        default:
+            criticalFunctions_.emplace_back(std::move(function));
+            break;
+        }
+    }
+
+    size_t EventLoop::runBackgroundFunctions(std::chrono::steady_clock::time_point start)
+    {
+        std::chrono::microseconds budget(pendingTimeBudget_.load());
+        size_t count = 0;
+        while (!backgroundFunctions_.empty())
+        {
+            if (budget.count() > 0 && count > 0 && std::chrono::steady_clock::now() - start >= budget)
+            {
+                // 剩余的任务留到下一轮，loop() 中的 epoll_wait 不会阻塞
+                break;
+            }
+
+            // 先移出队列再执行，任务中可能再次投递任务
+            PendingFunction function(std::move(backgroundFunctions_.front()));
+            backgroundFunctions_.pop_front();
+            runPendingFunction(function);
+            ++count;
+        }
+        return count;
+    }
+
+    void EventLoop::runPendingFunction(PendingFunction &function)
+    {
+        if (dropBudget_ > 0 && function.sheddable)
+        {
+            --dropBudget_;
+            ++droppedCount_;
+            return;
+        }
+        function.func();
+    }
+
+    bool EventLoop::reservePending(size_t capacity)
+    {
+        if (capacity == 0)
+        {
+            ++pendingCount_;
+            return true;
+        }
+        size_t count = pendingCount_.load();
+        while (count < capacity)
+        {
+            if (pendingCount_.compare_exchange_weak(count, count + 1))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void EventLoop::releasePending(size_t count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        pendingCount_ -= count;
+        if (blockedProducers_ > 0)
+        {
+            {
+                std::unique_lock<std::mutex> locker(mutex_);
+            }
+            notFull_.notify_all();
+        }
+    }
+
+    void EventLoop::collectChannelFunctions()
+    {
+        if (inChannelsChanged_.exchange(false))
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            inChannelsSnapshot_ = inChannels_;
+        }
+
+        bool remaining = false;
+        bool producerGone = false;
+        for (auto &channel : inChannelsSnapshot_)
+        {
+            size_t n = channel->functions.consume(
+                [this](PendingFunction &function) { collectFunction(function); },
+                MaxFunctionsPerChannel);
+            if (n == MaxFunctionsPerChannel)
+            {
+                remaining = true;
+            }
+            else if (!channel->producerAlive)
+            {
+                producerGone = true;
+            }
+        }
+
+        if (producerGone)
+        {
+            // 生产者 loop 已析构，且通道中的任务都已取出
+            auto isGone = [](const LoopChannelPtr &channel) {
+                return !channel->producerAlive && channel->functions.empty();
+            };
+            std::unique_lock<std::mutex> locker(mutex_);
+            inChannels_.erase(std::remove_if(inChannels_.begin(), inChannels_.end(), isGone), inChannels_.end());
+            inChannelsSnapshot_ = inChannels_;
+        }
+
+        if (remaining && !channelWakeupPending_.exchange(true))
+        {
+            wakeup();
+        }
+    }
+
+    EventLoop::LoopChannel *EventLoop::channelTo(EventLoop *consumer)
+    {
+        auto it = outChannels_.find(consumer);
+        if (it != outChannels_.end())
+        {
+            if (it->second->consumerAlive)
+            {
+                return it->second.get();
+            }
+            // 原来的 loop 已经析构，consumer 是复用了同一地址的新 loop
+            it->second->producerAlive = false;
+            outChannels_.erase(it);
+        }
+
+        LoopChannelPtr channel = std::make_shared<LoopChannel>();
+        {
+            std::unique_lock<std::mutex> locker(consumer->mutex_);
+            consumer->inChannels_.push_back(channel);
+        }
+        consumer->inChannelsChanged_ = true;
+        outChannels_.emplace(consumer, channel);
+        return channel.get();
+    }
+
     void EventLoop::wakeupReadCallback()
     {
         uint64_t one = 1;
@@ -114,13 +342,28 @@ namespace stnl
         running_ = true;
 
         ChannelVector activeChannels;
+        int64_t lastActiveTime = 0;     // 微秒，最近一次有事件发生的时间
         while (running_)
         {
             activeChannels.clear();
 
             // 1. epoll_wait(), 获取有事件发生的events
-            Timestamp selectReturnTime = selector_->select(activeChannels, Epoll::EPOLL_TIMEOUT);
+            // 有推迟的 Background 任务时不阻塞，处理完就绪的 IO 事件后继续执行；
+            // 忙轮询模式下，最近一次有事件发生后的 busyPollDuration_ 内同样不阻塞
+            int timeout = backgroundFunctions_.empty() ? Epoll::EPOLL_TIMEOUT : 0;
+            int64_t busyPollDuration = busyPollDuration_;
+            if (timeout != 0 && busyPollDuration > 0 &&
+                Timestamp::now().mircoSecondsSinceEpoch() - lastActiveTime < busyPollDuration)
+            {
+                timeout = 0;
+            }
+            Timestamp selectReturnTime = selector_->select(activeChannels, timeout);
             // LOG_INFO << "select()";
+            LogContext::setThreadClock(selectReturnTime.mircoSecondsSinceEpoch());
+            if (busyPollDuration > 0 && !activeChannels.empty())
+            {
+                lastActiveTime = selectReturnTime.mircoSecondsSinceEpoch();
+            }
 
             // 2. 执行 events 上注册的回调函数
             for (auto channel : activeChannels)
@@ -128,16 +371,30 @@ namespace stnl
                 channel->handleEvents(selectReturnTime);
             }
 
+            // 整个 select 超时周期内都没有事件发生，loop 处于空闲状态，释放池中长时间未用的内存
+            if (activeChannels.empty() && timeout != 0)
+            {
+                bufferPool_->shrink();
+            }
+
             // LOG_INFO << "doPendingFunctions()";
             doPendingFunctions();
         }
 
+        LogContext::setThreadClock(0);
         looping_ = false;
     }
 
     void EventLoop::quit()
     {
         running_ = false;
+        quitRequested_ = true;
+
+        // loop 退出后不再取出任务，唤醒所有因 Block 策略而等待的生产者
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+        }
+        notFull_.notify_all();
 
         // 若在其他线程（loop被创建的线程）调用quit()，需要进行哪些处理。
         if (!isInLoopThread())
@@ -162,11 +419,104 @@ namespace stnl
         }
     }
 
-    void EventLoop::queueInLoop(Func func)
+    void EventLoop::queueInLoop(Func func, Priority priority)
     {
+        ++pendingCount_;
+        enqueue(PendingFunction{std::move(func), false, priority});
+    }
+
+    EventLoop::QueueStatus EventLoop::tryQueueInLoop(Func func, Priority priority)
+    {
+        size_t capacity = pendingCapacity_;
+        if (capacity == 0)
+        {
+            ++pendingCount_;
+        }
+        else
+        {
+            switch (overflowPolicy_.load())
+            {
+            case OverflowPolicy::Reject:
+                if (pendingCount_.fetch_add(1) >= capacity)
+                {
+                    --pendingCount_;
+                    ++rejectedCount_;
+                    return QueueStatus::Rejected;
+                }
+                break;
+
+            case OverflowPolicy::Block:
+                // loop 线程等待自己取出任务会造成死锁，因此不阻塞；quit() 之后也不再阻塞
+                if (isInLoopThread() || quitRequested_)
+                {
+                    ++pendingCount_;
+                }
+                else if (!reservePending(capacity))
+                {
+                    // 在等待条件中占用名额，多个生产者被同时唤醒时也不会超过容量
+                    std::unique_lock<std::mutex> locker(mutex_);
+                    ++blockedProducers_;
+                    bool reserved = false;
+                    notFull_.wait(locker, [this, &reserved]() {
+                        reserved = reservePending(pendingCapacity_);
+                        return reserved || quitRequested_;
+                    });
+                    --blockedProducers_;
+                    if (!reserved)
+                    {
+                        ++pendingCount_;
+                    }
+                }
+                break;
+
+            case OverflowPolicy::DropOldest:
+                enqueueDropOldest(PendingFunction{std::move(func), true, priority}, capacity);
+                return QueueStatus::Queued;
+            }
+        }
+
+        enqueue(PendingFunction{std::move(func), true, priority});
+        return QueueStatus::Queued;
+    }
+
+    void EventLoop::setPendingQueueCapacity(size_t capacity, OverflowPolicy policy)
+    {
+        overflowPolicy_ = policy;
+        pendingCapacity_ = capacity;
+
+        // 容量变大或取消限制后，让等待中的生产者重新检查
         {
             std::unique_lock<std::mutex> locker(mutex_);
-            pendingFunctions_.emplace_back(std::move(func));
+        }
+        notFull_.notify_all();
+    }
+
+    void EventLoop::setPendingTimeBudget(double seconds)
+    {
+        pendingTimeBudget_ = seconds > 0.0 ? static_cast<int64_t>(seconds * 1000 * 1000) : 0;
+    }
+
+    void EventLoop::setBusyPollDuration(double seconds)
+    {
+        busyPollDuration_ = seconds > 0.0 ? static_cast<int64_t>(seconds * 1000 * 1000) : 0;
+    }
+
+    void EventLoop::enqueue(PendingFunction &&function)
+    {
+        EventLoop *producer = loopInCurrentThread;
+        if (producer && producer != this)
+        {
+            producer->channelTo(this)->functions.push(std::move(function));
+            if (!channelWakeupPending_.exchange(true))
+            {
+                wakeup();
+            }
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            pendingFunctions_.emplace_back(std::move(function));
         }
 
         if (!isInLoopThread() || callingPendingFunctions_)
@@ -176,6 +526,35 @@ namespace stnl
         }
     }
 
+    void EventLoop::enqueueDropOldest(PendingFunction &&function, size_t capacity)
+    {
+        // 被丢弃的任务移到锁外析构
+        Func dropped;
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            if (!reservePending(capacity))
+            {
+                if (!sheddableFunctions_.empty())
+                {
+                    dropped = std::move(sheddableFunctions_.front().func);
+                    sheddableFunctions_.pop_front();
+                    ++droppedCount_;
+                }
+                else
+                {
+                    // 可丢弃的任务都已被 loop 取出，暂时超出容量，由 doPendingFunctions 丢弃
+                    ++pendingCount_;
+                }
+            }
+            sheddableFunctions_.emplace_back(std::move(function));
+        }
+
+        if (!isInLoopThread() || callingPendingFunctions_)
+        {
+            wakeup();
+        }
+    }
+
     void EventLoop::updateChannel(Channel *channel)
     {
         selector_->updateChannel(channel);
@@ -210,4 +589,9 @@ namespace stnl
         timerQueue_->cancel(timerId);
     }
 
+    void EventLoop::SleepAwaitable::await_suspend(std::coroutine_handle<> handle)
+    {
+        loop_->runAfter(seconds_, [handle]() { handle.resume(); });
+    }
+
 }
@@ -3,10 +3,15 @@
 
 #include <memory>
 #include <vector>
+#include <deque>
+#include <chrono>
 #include <atomic>
 #include <functional>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <coroutine>
+#include <unordered_map>
 
 namespace stnl
 {
@@ -16,6 +21,7 @@ namespace stnl
     class TimerId;
     class TimerQueue;
     class Timestamp;
+    class BufferPool;
     using TimerCallback = std::function<void()>;
 
     /**
@@ -27,6 +33,51 @@ namespace stnl
     public:
         using Func = std::function<void()>;
 
+        /**
+         * 待执行任务数达到容量上限后，tryQueueInLoop 的处理方式
+         */
+        enum class OverflowPolicy
+        {
+            Block,      // 阻塞调用者直到有空位（loop 线程自己调用时不阻塞）
+            Reject,     // 拒绝新任务，返回 QueueStatus::Rejected
+            DropOldest  // 接受新任务，待执行任务数达到容量时在入队时丢弃最早的可丢弃任务
+        };
+
+        enum class QueueStatus
+        {
+            Queued,
+            Rejected
+        };
+
+        /**
+         * 任务的优先级。doPendingFunctions 先执行全部 Control 任务，再执行全部 IoCritical 任务，
+         * 最后在时间预算内执行 Background 任务，超出预算的 Background 任务推迟到下一轮。
+         */
+        enum class Priority
+        {
+            Control,        // 控制类任务，如 quit、配置变更
+            IoCritical,     // 与网络 IO 相关的任务（默认），如连接的建立与销毁、跨线程发送数据
+            Background,     // 可以延后的维护类任务，如统计、清理
+            NumPriorities
+        };
+
+        /**
+         * co_await loop->sleep(seconds)，通过定时器在 loop 线程中恢复协程。
+         */
+        class SleepAwaitable
+        {
+        public:
+            SleepAwaitable(EventLoop* loop, double seconds): loop_(loop), seconds_(seconds) {}
+
+            bool await_ready() const { return seconds_ <= 0.0; }
+            void await_suspend(std::coroutine_handle<> handle);
+            void await_resume() const {}
+
+        private:
+            EventLoop* loop_;
+            double seconds_;
+        };
+
         EventLoop();
 
         ~EventLoop();
@@ -37,7 +88,52 @@ namespace stnl
 
         void runInLoop(Func func);
 
-        void queueInLoop(Func func);
+        /**
+         * 若调用者是另一个 EventLoop 所在的线程，func 通过两个 loop 之间专用的
+         * 单生产者/单消费者无锁通道传递，不与其他生产者竞争 mutex_；
+         * 同一批次的任务只唤醒一次目标 loop。
+         */
+        void queueInLoop(Func func, Priority priority = Priority::IoCritical);
+
+        /**
+         * 与 queueInLoop 相同，但受 setPendingQueueCapacity 设置的容量限制。
+         * 用于投递可以被拒绝或丢弃的业务任务，过载时按 OverflowPolicy 削减负载。
+         * queueInLoop/runInLoop 投递的任务（如连接的建立与销毁）计入容量，但从不被拒绝或丢弃。
+         *
+         * DropOldest 策略下的任务不经过 loop 之间的通道，统一放入 sheddableFunctions_，
+         * 因此与 queueInLoop 投递的任务之间不保证先后顺序。
+         */
+        QueueStatus tryQueueInLoop(Func func, Priority priority = Priority::IoCritical);
+
+        /**
+         * 设置待执行任务的容量上限，capacity 为 0 表示不限制（默认）
+         */
+        void setPendingQueueCapacity(size_t capacity, OverflowPolicy policy = OverflowPolicy::Reject);
+
+        size_t pendingQueueCapacity() const { return pendingCapacity_; }
+
+        /**
+         * 每轮 doPendingFunctions 执行 Background 任务的时间预算（秒），从本轮开始执行任务时计时，
+         * 用完后剩余的 Background 任务推迟到下一轮，且下一次 epoll_wait 不再阻塞。
+         * 每轮至少执行一个 Background 任务。seconds <= 0 表示不限制（默认）。
+         */
+        void setPendingTimeBudget(double seconds);
+
+        /**
+         * 忙轮询模式：最近一次有事件发生后的 seconds 秒内，epoll_wait 使用 0 超时持续轮询，
+         * 之后再恢复阻塞等待。避免线程阻塞后被唤醒的延迟，代价是轮询期间占满一个 CPU。
+         * seconds <= 0 表示关闭（默认）。
+         */
+        void setBusyPollDuration(double seconds);
+
+        /* 尚未执行的任务数 */
+        size_t pendingFunctionCount() const { return pendingCount_; }
+
+        /* 被 Reject 策略拒绝的任务数 */
+        uint64_t rejectedFunctionCount() const { return rejectedCount_; }
+
+        /* 被 DropOldest 策略丢弃的任务数 */
+        uint64_t droppedFunctionCount() const { return droppedCount_; }
 
         void updateChannel(Channel*);
 
@@ -62,9 +158,71 @@ namespace stnl
 
         void cancelTimer(TimerId timerId);
 
+        SleepAwaitable sleep(double seconds) { return SleepAwaitable(this, seconds); }
+
+        /**
+         * 属于该 loop 的 NetBuffer 内存池，只在 loop 线程中复用内存块。
+         */
+        const std::shared_ptr<BufferPool>& bufferPool() const { return bufferPool_; }
+
     private:
+        struct PendingFunction
+        {
+            Func func;
+            bool sheddable;     // 由 tryQueueInLoop 投递，可以被 DropOldest 策略丢弃
+            Priority priority;
+        };
+
+        struct LoopChannel;
+        using LoopChannelPtr = std::shared_ptr<LoopChannel>;
+
+        /**
+         * 每个 loop 的每个通道在一次 doPendingFunctions 中最多取出的任务数，
+         * 剩余的任务留到下一轮，避免生产者持续写入时 loop 无法回到 epoll_wait
+         */
+        static const size_t MaxFunctionsPerChannel = 1024;
+
         void doPendingFunctions();
 
+        /**
+         * 在生产者 loop 线程中调用，获取（必要时创建）从当前 loop 到 consumer 的通道
+         */
+        LoopChannel* channelTo(EventLoop* consumer);
+
+        /**
+         * 将各个通道中的任务按优先级取出到 controlFunctions_ 等队列中
+         */
+        void collectChannelFunctions();
+
+        void collectFunction(PendingFunction &function);
+
+        void enqueue(PendingFunction &&function);
+
+        /**
+         * DropOldest 策略的入队：达到容量时丢弃 sheddableFunctions_ 中最早的任务，新任务沿用它的名额
+         */
+        void enqueueDropOldest(PendingFunction &&function, size_t capacity);
+
+        /**
+         * 执行或丢弃（DropOldest）一个取出的任务
+         */
+        void runPendingFunction(PendingFunction &function);
+
+        /**
+         * 在时间预算内执行 backgroundFunctions_ 中的任务，返回执行（或丢弃）的任务数
+         */
+        size_t runBackgroundFunctions(std::chrono::steady_clock::time_point start);
+
+        /**
+         * 待执行任务数小于 capacity 时占用一个名额（capacity 为 0 表示不限制），返回是否成功
+         */
+        bool reservePending(size_t capacity);
+
+        /**
+         * 已执行（或丢弃）count 个任务，唤醒因 Block 策略而等待的生产者
+         */
+        void releasePending(size_t count);
+
         /**
          * wakeupFd_上可读事件的回调函数。从wakeupFd_上读取数据。
         */
@@ -85,11 +243,42 @@ namespace stnl
 
         std::unique_ptr<TimerQueue> timerQueue_;
 
+        std::shared_ptr<BufferPool> bufferPool_;
+
         std::mutex mutex_;
         int wakeupFd_;
         std::unique_ptr<Channel> wakeupChannel_;
-        std::vector<Func> pendingFunctions_;
+        std::vector<PendingFunction> pendingFunctions_;
+        std::deque<PendingFunction> sheddableFunctions_;   // DropOldest 策略投递的任务，由 mutex_ 保护
         bool callingPendingFunctions_;
+
+        // 待执行任务的容量控制，pendingCount_ 包括 pendingFunctions_ 与所有通道中的任务
+        std::atomic_size_t pendingCount_;
+        std::atomic_size_t pendingCapacity_;
+        std::atomic<OverflowPolicy> overflowPolicy_;
+        std::atomic_uint64_t rejectedCount_;
+        std::atomic_uint64_t droppedCount_;
+        std::atomic_int blockedProducers_;
+        std::atomic_bool quitRequested_;      // 调用过 quit()，不再阻塞生产者
+        std::condition_variable notFull_;      // 与 mutex_ 配合使用
+        size_t dropBudget_;                    // 本轮还需丢弃的任务数（入队时无法丢弃而超出容量的部分），只在 loop 线程中使用
+
+        // 按优先级分开的本轮任务，只在 loop 线程中使用
+        std::vector<PendingFunction> controlFunctions_;
+        std::vector<PendingFunction> criticalFunctions_;
+        std::deque<PendingFunction> backgroundFunctions_;  // 包括之前推迟的任务
+        std::atomic_int64_t pendingTimeBudget_;            // 微秒，0 表示不限制
+
+        std::atomic_int64_t busyPollDuration_;             // 微秒，0 表示不轮询
+
+        // 其他 loop 发往本 loop 的通道，由 mutex_ 保护；inChannelsSnapshot_ 只在 loop 线程中使用
+        std::vector<LoopChannelPtr> inChannels_;
+        std::vector<LoopChannelPtr> inChannelsSnapshot_;
+        std::atomic_bool inChannelsChanged_;
+        std::atomic_bool channelWakeupPending_;   // 已经为通道中的任务唤醒过本 loop，尚未处理
+
+        // 本 loop 发往其他 loop 的通道，只在 loop 线程中使用
+        std::unordered_map<EventLoop*, LoopChannelPtr> outChannels_;
     };
 
 }
@@ -33,6 +33,15 @@ stnl::EventLoop *stnl::EventLoopThreadPool::getNextLoop()
     return loop;
 }
 
+std::vector<stnl::EventLoop *> stnl::EventLoopThreadPool::getAllLoops() const
+{
+    if (loops_.empty())
+    {
+        return std::vector<EventLoop *>(1, mainLoop_);
+    }
+    return loops_;
+}
+
 void stnl::EventLoopThreadPool::start()
 {
     for (int i = 0; i < threadNums_; ++i)
@@ -20,6 +20,11 @@ namespace stnl
 
         EventLoop* getNextLoop();
 
+        /**
+         * 所有的子 loop，没有子 loop 时返回 mainLoop
+         */
+        std::vector<EventLoop*> getAllLoops() const;
+
         void start();
 
         void setThreadNums(int threadNums)
@@ -0,0 +1,127 @@
+#include "LengthHeaderCodec.h"
+#include "logger.h"
+#include "TimeUtil.h"
+
+#include <endian.h>
+#include <cstring>
+#include <algorithm>
+
+using namespace stnl;
+
+const size_t LengthHeaderCodec::DefaultMaxMessageLength;
+
+LengthHeaderCodec::LengthHeaderCodec(const StringMessageCallback &cb,
+                                     int headerLength,
+                                     size_t maxMessageLength)
+    : messageCallback_(cb),
+      headerLength_(headerLength),
+      maxMessageLength_(headerLength == 2 ? std::min<size_t>(maxMessageLength, UINT16_MAX) : maxMessageLength)
+{
+    if (headerLength_ != 2 && headerLength_ != 4 && headerLength_ != 8)
+    {
+        LOG_FATAL << "LengthHeaderCodec headerLength should be 2, 4 or 8, not " << headerLength_;
+    }
+    static_assert(NetBuffer::ReservedPrependSize >= sizeof(int64_t));
+}
+
+size_t LengthHeaderCodec::peekLength(const char *data) const
+{
+    switch (headerLength_)
+    {
+    case 2:
+    {
+        uint16_t be16;
+        ::memcpy(&be16, data, sizeof(be16));
+        return be16toh(be16);
+    }
+    case 4:
+    {
+        uint32_t be32;
+        ::memcpy(&be32, data, sizeof(be32));
+        return be32toh(be32);
+    }
+    default:
+    {
+        uint64_t be64;
+        ::memcpy(&be64, data, sizeof(be64));
+        return static_cast<size_t>(be64toh(be64));
+    }
+    }
+}
+
+void LengthHeaderCodec::onMessage(const TcpConnectionPtr &conn, NetBuffer *buf, Timestamp receiveTime)
+{
+    const char *data = buf->peek();
+    const size_t readable = buf->readableBytes();
+    const size_t headerLength = static_cast<size_t>(headerLength_);
+
+    /*
+        先把 buffer 中所有完整的消息逐条交给用户，最后再一次性 retrieve。
+        消息在回调期间直接引用 buffer 中的数据，不做拷贝。
+    */
+    size_t offset = 0;
+    while (readable - offset >= headerLength)
+    {
+        size_t length = peekLength(data + offset);
+        if (length > maxMessageLength_)
+        {
+            LOG_ERROR << "LengthHeaderCodec::onMessage invalid length " << length
+                      << ", max message length is " << maxMessageLength_;
+            if (conn)
+            {
+                conn->shutdown();
+            }
+            buf->retrieveAll();
+            return;
+        }
+
+        if (readable - offset - headerLength < length)
+        {
+            // 不完整的消息，等待后续数据
+            break;
+        }
+
+        messageCallback_(conn, std::string_view(data + offset + headerLength, length), receiveTime);
+        offset += headerLength + length;
+    }
+
+    buf->retrieve(offset);
+}
+
+bool LengthHeaderCodec::encode(NetBuffer *buf) const
+{
+    size_t length = buf->readableBytes();
+    if (length > maxMessageLength_)
+    {
+        LOG_ERROR << "LengthHeaderCodec::encode message length " << length
+                  << " exceeds max message length " << maxMessageLength_;
+        return false;
+    }
+
+    switch (headerLength_)
+    {
+    case 2:
+        buf->prepend(static_cast<int16_t>(htobe16(static_cast<uint16_t>(length))));
+        break;
+    case 4:
+        buf->prepend(static_cast<int32_t>(htobe32(static_cast<uint32_t>(length))));
+        break;
+    default:
+        buf->prepend(static_cast<int64_t>(htobe64(static_cast<uint64_t>(length))));
+        break;
+    }
+    return true;
+}
+
+bool LengthHeaderCodec::send(const TcpConnectionPtr &conn, std::string_view message) const
+{
+    // 在 loop 线程中发送时，内存从 loop 的 BufferPool 中借用，发送后归还
+    NetBuffer buf(conn->getLoop()->bufferPool());
+    buf.append(message);
+    if (!encode(&buf))
+    {
+        return false;
+    }
+    conn->send(&buf);
+    return true;
+}
@@ -0,0 +1,77 @@
+#ifndef STNL_LENGTHHEADERCODEC_H
+#define STNL_LENGTHHEADERCODEC_H
+
+#include <functional>
+#include <string_view>
+
+#include "noncopyable.h"
+#include "TcpConnection.h"
+
+namespace stnl
+{
+
+    /**
+     * @brief 基于长度头的分包编解码器
+     *
+     *  +----------------------+-------------------------+
+     *  | length (2/4/8 bytes) |   message (length bytes) |
+     *  |     big-endian       |                          |
+     *  +----------------------+-------------------------+
+     *
+     * 解码：将 onMessage 设置为 TcpConnection 的 MessageCallback，
+     * 一次调用中依次解析 inputBuffer_ 中所有完整的消息，以 std::string_view 的形式交给用户（不拷贝），
+     * 全部处理完后只调用一次 retrieve，不完整的消息留在 buffer 中等待后续数据。
+     *
+     * 编码：消息写入 NetBuffer 后，利用 NetBuffer 预留的 8 字节 prepend 空间写入长度头。
+     */
+    class LengthHeaderCodec : public noncopyable
+    {
+    public:
+        using TcpConnectionPtr = TcpConnection::TcpConnectionPtr;
+
+        /**
+         * message 指向 inputBuffer_ 中的数据，只在回调函数执行期间有效
+         */
+        using StringMessageCallback = std::function<void(const TcpConnectionPtr &conn, std::string_view message, Timestamp receiveTime)>;
+
+        static const size_t DefaultMaxMessageLength = 64 * 1024 * 1024; // 64MB
+
+        /**
+         * @param cb 收到一条完整消息时的回调函数
+         * @param headerLength 长度头的字节数，只能是 2、4 或 8
+         * @param maxMessageLength 允许的最大消息长度，超过则视为非法数据并关闭连接
+         */
+        explicit LengthHeaderCodec(const StringMessageCallback &cb,
+                                   int headerLength = 4,
+                                   size_t maxMessageLength = DefaultMaxMessageLength);
+
+        int headerLength() const { return headerLength_; }
+
+        void onMessage(const TcpConnectionPtr &conn, NetBuffer *buf, Timestamp receiveTime);
+
+        /**
+         * 为 message 加上长度头后发送。消息超过最大长度时不发送，返回 false
+         */
+        bool send(const TcpConnectionPtr &conn, std::string_view message) const;
+
+        /**
+         * 将 buf 中的全部可读数据视为一条消息，在其前面 prepend 长度头。
+         * 消息超过最大长度（2 字节长度头时不超过 65535）时长度头无法表示，buf 保持不变并返回 false
+         */
+        bool encode(NetBuffer *buf) const;
+
+    private:
+        /**
+         * 以大端序读取 data 处的长度头
+         */
+        size_t peekLength(const char *data) const;
+
+    private:
+        StringMessageCallback messageCallback_;
+        const int headerLength_;
+        const size_t maxMessageLength_;
+    };
+
+}
+
+#endif
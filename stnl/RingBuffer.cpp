@@ -0,0 +1,134 @@
+#include "RingBuffer.h"
+#include "logger.h"
+
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace stnl;
+
+const size_t RingBuffer::InitialBufferSize;
+
+RingBuffer::RingBuffer(size_t initialBufferSize) : base_(nullptr),
+                                                   capacity_(roundUpToPageSize(initialBufferSize)),
+                                                   readIndex_(0),
+                                                   readable_(0)
+{
+    base_ = mapMirrored(capacity_);
+    assert(readableBytes() == 0);
+    assert(writeableBytes() >= initialBufferSize);
+}
+
+RingBuffer::~RingBuffer()
+{
+    ::munmap(base_, capacity_ * 2);
+}
+
+size_t RingBuffer::roundUpToPageSize(size_t size)
+{
+    static const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    if (size == 0)
+    {
+        size = pageSize;
+    }
+    return (size + pageSize - 1) / pageSize * pageSize;
+}
+
+/**
+ * 1. 用 memfd_create 创建一块大小为 size 的匿名内存文件
+ * 2. 预留 2 * size 的连续虚拟地址空间
+ * 3. 将内存文件分别映射到预留空间的前半部分和后半部分
+ */
+char *RingBuffer::mapMirrored(size_t size)
+{
+    int fd = ::memfd_create("stnl-ringbuffer", MFD_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_FATAL << "RingBuffer memfd_create() error, errno = " << errno;
+    }
+
+    if (::ftruncate(fd, static_cast<off_t>(size)) < 0)
+    {
+        LOG_FATAL << "RingBuffer ftruncate() error, errno = " << errno;
+    }
+
+    void *reserved = ::mmap(nullptr, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED)
+    {
+        LOG_FATAL << "RingBuffer mmap() reserve error, errno = " << errno;
+    }
+
+    char *base = static_cast<char *>(reserved);
+    void *first = ::mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    void *second = ::mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    if (first == MAP_FAILED || second == MAP_FAILED)
+    {
+        LOG_FATAL << "RingBuffer mmap() mirror error, errno = " << errno;
+    }
+
+    // 映射建立后，文件描述符就不再需要了
+    ::close(fd);
+    return base;
+}
+
+void RingBuffer::grow(size_t len)
+{
+    size_t newCapacity = roundUpToPageSize(std::max(capacity_ * 2, readable_ + len));
+    char *newBase = mapMirrored(newCapacity);
+    std::memcpy(newBase, peek(), readable_);
+    ::munmap(base_, capacity_ * 2);
+
+    base_ = newBase;
+    capacity_ = newCapacity;
+    readIndex_ = 0;
+}
+
+void RingBuffer::append(const char *buf, size_t len)
+{
+    if (len > writeableBytes())
+    {
+        grow(len);
+    }
+    std::memcpy(writeIndex(), buf, len);
+    readable_ += len;
+}
+
+void RingBuffer::prepend(const void *buf, size_t len)
+{
+    assert(len <= writeableBytes());
+    readIndex_ = (readIndex_ + capacity_ - len) % capacity_;
+    readable_ += len;
+    std::memcpy(base_ + readIndex_, buf, len);
+}
+
+ssize_t RingBuffer::readFD(int fd, int *savedErrno)
+{
+    char extrabuf[65536]; // 64KB
+    struct iovec vec[2];
+    const size_t writeable = writeableBytes();
+    vec[0].iov_base = writeIndex();
+    vec[0].iov_len = writeable;
+    vec[1].iov_base = extrabuf;
+    vec[1].iov_len = sizeof(extrabuf);
+
+    const int vec_size = writeable < sizeof(extrabuf) ? 2 : 1;
+    ssize_t n = ::readv(fd, vec, vec_size);
+
+    if (n < 0)
+    {
+        *savedErrno = errno;
+    }
+    else if (static_cast<size_t>(n) <= writeable)
+    {
+        readable_ += n;
+    }
+    else
+    {
+        readable_ += writeable;
+        append(extrabuf, n - writeable);
+    }
+
+    return n;
+}
@@ -0,0 +1,139 @@
+#ifndef STNL_RINGBUFFER_H
+#define STNL_RINGBUFFER_H
+
+#include <string>
+#include <string_view>
+#include <assert.h>
+#include <sys/types.h>
+
+#include "noncopyable.h"
+
+namespace stnl
+{
+
+    /**
+     * @brief 基于双重映射（double-mapped）虚拟内存的环形缓冲区
+     *
+     * 同一块物理内存（memfd）被连续映射两次：
+     *
+     *  +---------------------------+---------------------------+
+     *  |        mapping #1         |   mapping #2 (同一块内存)   |
+     *  +---------------------------+---------------------------+
+     *  0        readIndex          capacity    readIndex+readable
+     *
+     * 因此从 readIndex 开始的 readable 个字节在虚拟地址上总是连续的，
+     * 读出数据后只需移动 readIndex，永远不需要像 NetBuffer::memoryMoving() 那样搬移数据。
+     * 只有当数据总量超过 capacity 时才会重新分配更大的映射（拷贝一次）。
+     *
+     * 接口与 NetBuffer 保持一致，可用于存在大量"半包"数据的长连接场景。
+     */
+    class RingBuffer : public noncopyable
+    {
+    public:
+        static const size_t InitialBufferSize = 64 * 1024; // 64kB
+
+        explicit RingBuffer(size_t initialBufferSize = InitialBufferSize);
+
+        ~RingBuffer();
+
+        size_t capacity() const
+        {
+            return capacity_;
+        }
+
+        size_t readableBytes() const
+        {
+            return readable_;
+        }
+
+        size_t writeableBytes() const
+        {
+            return capacity_ - readable_;
+        }
+
+        const char *peek() const
+        {
+            return base_ + readIndex_;
+        }
+
+        char *writeIndex()
+        {
+            return base_ + readIndex_ + readable_;
+        }
+
+        const char *writeIndex() const
+        {
+            return base_ + readIndex_ + readable_;
+        }
+
+        void append(const char *buf, size_t len);
+
+        void append(const void *buf, size_t len)
+        {
+            append(static_cast<const char *>(buf), len);
+        }
+
+        void append(std::string_view buf)
+        {
+            append(buf.data(), buf.size());
+        }
+
+        /*
+            环形缓冲区中，readIndex 之前的空闲空间都可以用于 prepend，不受 8 字节的限制。
+        */
+        void prepend(const void *buf, size_t len);
+
+        void retrieve(size_t len)
+        {
+            assert(len <= readableBytes());
+            readIndex_ = (readIndex_ + len) % capacity_;
+            readable_ -= len;
+        }
+
+        void retrieveAll()
+        {
+            readIndex_ = 0;
+            readable_ = 0;
+        }
+
+        std::string retrieveAsString(size_t len)
+        {
+            assert(len <= readableBytes());
+            std::string res(peek(), len);
+            retrieve(len);
+            return res;
+        }
+
+        std::string retrieveAllAsString()
+        {
+            return retrieveAsString(readableBytes());
+        }
+
+        /**
+         * 将文件描述符中的数据读入 buffer
+         */
+        ssize_t readFD(int fd, int *savedErrno);
+
+    private:
+        /**
+         * 重新映射一块至少为 len 字节的内存，并将可读数据拷贝过去。
+         */
+        void grow(size_t len);
+
+        /**
+         * 创建一块大小为 size 的双重映射内存，size 必须是页大小的整数倍。
+         */
+        static char *mapMirrored(size_t size);
+
+        static size_t roundUpToPageSize(size_t size);
+
+    private:
+        char *base_;
+        size_t capacity_;
+        size_t readIndex_; // [0, capacity_)
+        size_t readable_;
+    };
+
+}
+
+#endif
@@ -7,6 +7,14 @@
 #include <unistd.h>
 #include "logger.h"
 
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
 using namespace stnl;
 
 /* -------------------------------------- SocketUtil ------------------------------------------------*/
@@ -33,7 +41,7 @@ void SocketUtil::listenSocket(int socketFd)
 
 int SocketUtil::acceptSocket(int socketFd, struct sockaddr *addr)
 {
-    socklen_t addrlen = static_cast<socklen_t>(sizeof(*addr));
+    socklen_t addrlen = static_cast<socklen_t>(sizeof(struct sockaddr_in6));
     int fd = ::accept4(socketFd, addr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
     if (fd < 0)
     {
@@ -128,6 +136,24 @@ void SocketUtil::setKeepAlive(int socketFd, bool on)
     }
 }
 
+void SocketUtil::setBusyPoll(int socketFd, int microseconds)
+{
+    int optval = microseconds > 0 ? microseconds : 0;
+    if (::setsockopt(socketFd, SOL_SOCKET, SO_BUSY_POLL,
+        &optval, static_cast<socklen_t>(sizeof(optval))) < 0)
+    {
+        LOG_ERROR << "setsockopt SO_BUSY_POLL error. errno: " << errno;
+    }
+
+    int prefer = optval > 0 ? 1 : 0;
+    if (::setsockopt(socketFd, SOL_SOCKET, SO_PREFER_BUSY_POLL,
+        &prefer, static_cast<socklen_t>(sizeof(prefer))) < 0)
+    {
+        // 旧内核不支持 SO_PREFER_BUSY_POLL，SO_BUSY_POLL 仍然有效
+        LOG_DEBUG << "setsockopt SO_PREFER_BUSY_POLL error. errno: " << errno;
+    }
+}
+
 SockAddr SocketUtil::getLocalAddr(int socketFd)
 {
     // FIXME: 修改为 struct sockaddr_storage 处理 ipv4 和 ipv6
@@ -257,8 +283,9 @@ const struct sockaddr *SockAddr::getSockAddr() const
 
 void SockAddr::setSockAddr6(const sockaddr_in6 addr6)
 {
+    // accept 时以 sockaddr_in6 接收对端地址，对端为 ipv4 时其中存放的是 sockaddr_in
     addr6_ = addr6;
-    ipv6_ = true;
+    ipv6_ = addr6.sin6_family == AF_INET6;
 }
 
 void SockAddr::setSockAddr4(const sockaddr_in addr)
@@ -324,6 +351,11 @@ void Socket::setPortReuse(bool on)
     SocketUtil::setPortReuse(socketFd_, on);
 }
 
+void Socket::setBusyPoll(int microseconds)
+{
+    SocketUtil::setBusyPoll(socketFd_, microseconds);
+}
+
 void Socket::setTcpNoDelay(bool on)
 {
     SocketUtil::setTcpNoDelay(socketFd_, on);
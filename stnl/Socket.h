@@ -38,6 +38,13 @@ namespace stnl
 
         static void setKeepAlive(int socketFd, bool on);
 
+        /**
+         * SO_BUSY_POLL：阻塞读取该 socket 时，在网卡接收队列上忙轮询的微秒数，
+         * 同时设置 SO_PREFER_BUSY_POLL（内核 5.11 及以上）。需要 CAP_NET_ADMIN 才能调大系统默认值，
+         * 设置失败时只记录日志。
+         */
+        static void setBusyPoll(int socketFd, int microseconds);
+
         static SockAddr getLocalAddr(int socketFd);
 
         static SockAddr getPeerAddr(int socketFd);
@@ -122,6 +129,8 @@ namespace stnl
 
         void setPortReuse(bool on);
 
+        void setBusyPoll(int microseconds);
+
         /**
          * enable/disable Nagle's algorithm
         */
@@ -0,0 +1,141 @@
+#ifndef STNL_SPSCQUEUE_H
+#define STNL_SPSCQUEUE_H
+
+#include <atomic>
+#include <new>
+#include <utility>
+#include <cstddef>
+
+#include "noncopyable.h"
+
+namespace stnl
+{
+
+    /**
+     * @brief 无锁的单生产者/单消费者队列
+     *
+     * 队列由固定大小的环形块（Block）串成链表：生产者只写尾块，消费者只读头块，
+     * 两者之间只通过 Block::published 与 Block::next 两个原子变量同步，不需要加锁。
+     * 尾块写满时生产者链接一个新块，因此 push 总是成功，同一生产者的元素保持 FIFO 顺序；
+     * 消费者读完的块留作备用块，稳态下不再分配内存。
+     *
+     * push 只能在同一个线程中调用，consume 只能在另一个（固定的）线程中调用。
+     */
+    template <typename T, size_t BlockSize = 256>
+    class SpscQueue : public noncopyable
+    {
+    public:
+        SpscQueue()
+            : head_(new Block()),
+              readIndex_(0),
+              tail_(head_),
+              spare_(nullptr)
+        {
+        }
+
+        ~SpscQueue()
+        {
+            consume([](T &) {}, static_cast<size_t>(-1));
+            delete head_;
+            delete spare_.load();
+        }
+
+        template <typename U>
+        void push(U &&value)
+        {
+            Block *block = tail_;
+            size_t index = block->published.load(std::memory_order_relaxed);
+            if (index == BlockSize)
+            {
+                Block *next = spare_.exchange(nullptr, std::memory_order_acquire);
+                if (next)
+                {
+                    next->published.store(0, std::memory_order_relaxed);
+                    next->next.store(nullptr, std::memory_order_relaxed);
+                }
+                else
+                {
+                    next = new Block();
+                }
+                block->next.store(next, std::memory_order_release);
+                tail_ = block = next;
+                index = 0;
+            }
+
+            new (block->slot(index)) T(std::forward<U>(value));
+            block->published.store(index + 1, std::memory_order_release);
+        }
+
+        /**
+         * 依次取出最多 maxCount 个元素交给 func 处理，返回取出的元素个数
+         */
+        template <typename Func>
+        size_t consume(Func &&func, size_t maxCount)
+        {
+            size_t count = 0;
+            while (count < maxCount)
+            {
+                size_t published = head_->published.load(std::memory_order_acquire);
+                if (readIndex_ < published)
+                {
+                    T *value = head_->slot(readIndex_++);
+                    func(*value);
+                    value->~T();
+                    ++count;
+                    continue;
+                }
+
+                if (readIndex_ < BlockSize)
+                {
+                    break;
+                }
+
+                // 头块已读完，生产者链接新块之后才能切换过去
+                Block *next = head_->next.load(std::memory_order_acquire);
+                if (!next)
+                {
+                    break;
+                }
+                Block *drained = head_;
+                head_ = next;
+                readIndex_ = 0;
+                delete spare_.exchange(drained, std::memory_order_release);
+            }
+            return count;
+        }
+
+        /**
+         * 只能在消费者线程中调用
+         */
+        bool empty() const
+        {
+            if (readIndex_ < head_->published.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            return readIndex_ < BlockSize || head_->next.load(std::memory_order_acquire) == nullptr;
+        }
+
+    private:
+        struct Block
+        {
+            std::atomic<size_t> published{0};   // 已经写入的元素个数，只由生产者修改
+            std::atomic<Block *> next{nullptr};
+            alignas(T) unsigned char storage[BlockSize * sizeof(T)];
+
+            T *slot(size_t index) { return std::launder(reinterpret_cast<T *>(storage) + index); }
+        };
+
+        // 消费者独占，与生产者的成员放在不同的缓存行中，避免伪共享
+        alignas(64) Block *head_;
+        size_t readIndex_;
+
+        // 生产者独占
+        alignas(64) Block *tail_;
+
+        alignas(64) std::atomic<Block *> spare_;
+    };
+
+}
+
+#endif
@@ -37,7 +37,8 @@ TcpClient::TcpClient(EventLoop* loop,
                                                 messageCallback_(defaultMessageCallback),
                                                 retry_(false),
                                                 connect_(true),
-                                                nextConnId_(1)
+                                                nextConnId_(1),
+                                                connectWaiter_(std::make_shared<ConnectWaiter>())
 {
     connector_->setNewConnectionCallback(
         std::bind(&TcpClient::newConnection, this, _1));
@@ -72,6 +73,18 @@ TcpClient::~TcpClient()
         // FIXME: HACK
         // loop_->runAfter(1, std::bind(&detail::removeConnector, connector_));
     }
+
+    // 仍在等待连接的协程以空连接恢复，让它执行完毕并释放协程帧
+    connectWaiter_->clientDestroyed = true;
+    if (loop_->isInLoopThread())
+    {
+        resumeConnectWaiter();
+    }
+    else
+    {
+        std::shared_ptr<ConnectWaiter> waiter = connectWaiter_;
+        loop_->queueInLoop([waiter]() { resumeWaiter(*waiter); });
+    }
 }
 
 void TcpClient::connect()
@@ -100,6 +113,49 @@ void TcpClient::stop()
     // LOG_INFO;
     connect_ = false;
     connector_->stop();
+    if (loop_->isInLoopThread())
+    {
+        resumeConnectWaiter();
+    }
+    else
+    {
+        // 调用 stop() 之后 TcpClient 可能立即析构，不能在回调中持有 this
+        std::weak_ptr<ConnectWaiter> weakWaiter = connectWaiter_;
+        loop_->queueInLoop([weakWaiter]() {
+            if (std::shared_ptr<ConnectWaiter> waiter = weakWaiter.lock())
+            {
+                resumeWaiter(*waiter);
+            }
+        });
+    }
+}
+
+TcpClient::ConnectAwaitable TcpClient::asyncConnect()
+{
+    loop_->assertInLoopThread();
+    return ConnectAwaitable(this);
+}
+
+void TcpClient::ConnectAwaitable::await_suspend(std::coroutine_handle<> handle)
+{
+    assert(!waiter_->handle);
+    waiter_->handle = handle;
+    client_->connect();
+}
+
+void TcpClient::resumeConnectWaiter()
+{
+    resumeWaiter(*connectWaiter_);
+}
+
+void TcpClient::resumeWaiter(ConnectWaiter &waiter)
+{
+    if (waiter.handle)
+    {
+        std::coroutine_handle<> handle = waiter.handle;
+        waiter.handle = nullptr;
+        handle.resume();
+    }
 }
 
 void TcpClient::newConnection(int socketFd)
@@ -126,6 +182,7 @@ void TcpClient::newConnection(int socketFd)
         connection_ = conn;
     }
     conn->connectionEstablish();
+    resumeConnectWaiter();
 }
 
 void TcpClient::removeConnection(const TcpConnectionPtr &conn)
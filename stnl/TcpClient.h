@@ -2,6 +2,7 @@
 #define STNL_TCPCLIENT_H
 
 #include "TcpConnection.h"
+#include <coroutine>
 
 namespace stnl
 {
@@ -23,6 +24,34 @@ namespace stnl
         using ConnectionCallback = std::function<void(const TcpConnectionPtr &)>;
         using CloseCallback = std::function<void(const TcpConnectionPtr &)>;
 
+        /**
+         * 等待连接建立的协程。由 TcpClient 与挂起中的 ConnectAwaitable 共同持有，
+         * 因此 TcpClient 析构之后，协程仍然可以知道 client 已不存在。
+         */
+        struct ConnectWaiter
+        {
+            std::coroutine_handle<> handle;
+            bool clientDestroyed = false;
+        };
+
+        /**
+         * co_await client.asyncConnect()，连接建立后在 loop 线程中恢复协程，返回新建立的连接。
+         * 若在连接建立前调用了 stop() 或 TcpClient 被析构，返回空指针。
+         */
+        class ConnectAwaitable
+        {
+        public:
+            explicit ConnectAwaitable(TcpClient *client) : client_(client), waiter_(client->connectWaiter_) {}
+
+            bool await_ready() const { return false; }
+            void await_suspend(std::coroutine_handle<> handle);
+            TcpConnectionPtr await_resume() const { return waiter_->clientDestroyed ? nullptr : client_->connection(); }
+
+        private:
+            TcpClient *client_;
+            std::shared_ptr<ConnectWaiter> waiter_;
+        };
+
         TcpClient(EventLoop* loop,
                   const SockAddr &addr,
                   const std::string &name);
@@ -31,6 +60,11 @@ namespace stnl
 
         void connect();
 
+        /**
+         * 协程接口，只能在 loop 线程中运行的协程里使用。
+         */
+        ConnectAwaitable asyncConnect();
+
         void disconnect();
 
         void stop();
@@ -70,6 +104,10 @@ namespace stnl
 
         void removeConnection(const TcpConnectionPtr &conn);
 
+        void resumeConnectWaiter();
+
+        static void resumeWaiter(ConnectWaiter &waiter);
+
     private:
         EventLoop* loop_;
         ConnectorPtr connector_;
@@ -82,6 +120,9 @@ namespace stnl
         int nextConnId_;
         mutable std::mutex mutex_;
         TcpConnectionPtr connection_;
+        /* 等待连接建立的协程，只在 loop 线程中访问。
+           其他线程中的 stop() 只持有它的 weak_ptr，TcpClient 析构之后不会再被访问 */
+        std::shared_ptr<ConnectWaiter> connectWaiter_;
     };
 
 }
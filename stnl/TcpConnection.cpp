@@ -18,7 +18,10 @@ TcpConnection::TcpConnection(EventLoop *loop,
       channel_(new Channel(loop, sockfd)),
       localAddr_(localAddr),
       peerAddr_(peerAddr),
-      socketState_(SocketState::CONNECTING)
+      inputBuffer_(loop->bufferPool()),
+      outputBuffer_(loop->bufferPool()),
+      socketState_(SocketState::CONNECTING),
+      readWanted_(0)
 {
     channel_->setReadEventCallback(std::bind(&TcpConnection::handleRead, this, _1));
     channel_->setCloseEventCallback(std::bind(&TcpConnection::handleClose, this));
@@ -165,7 +168,15 @@ void TcpConnection::handleRead(Timestamp receiveTime)
     ssize_t n = inputBuffer_.readFD(channel_->fd(), &savedErrno);
     if (n > 0)
     {
-        if (messageCallback_)
+        if (readWaiter_)
+        {
+            // 有协程在等待数据，直接恢复协程，不经过 messageCallback_
+            if (inputBuffer_.readableBytes() >= readWanted_)
+            {
+                resumeReader();
+            }
+        }
+        else if (messageCallback_)
         {
             messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
         }
@@ -204,6 +215,11 @@ void TcpConnection::handleWrite()
                 // NOTE:
                 shutdownInLoop();
             }
+
+            if (writeWaiter_ && outputBuffer_.readableBytes() == 0)
+            {
+                resumeWriter();
+            }
         }
         else
         {
@@ -234,6 +250,16 @@ void TcpConnection::handleClose()
     }
     // closeCallback_ --> TcpConnection::connectionDestory()
     closeCallback_(guardThis);
+
+    // 连接已断开，恢复所有等待中的协程
+    if (readWaiter_)
+    {
+        resumeReader();
+    }
+    if (writeWaiter_)
+    {
+        resumeWriter();
+    }
 }
 
 void TcpConnection::handleError()
@@ -279,3 +305,67 @@ void TcpConnection::forceCloseInLoop()
         handleClose();
     }
 }
+
+/* ------------------------------------ coroutine ------------------------------------- */
+
+TcpConnection::ReadAwaitable TcpConnection::read(std::size_t n)
+{
+    loop_->assertInLoopThread();
+    return ReadAwaitable(this, n);
+}
+
+TcpConnection::WriteAwaitable TcpConnection::write(std::string_view message)
+{
+    loop_->assertInLoopThread();
+    sendInLoop(message);
+    return WriteAwaitable(this);
+}
+
+void TcpConnection::resumeReader()
+{
+    std::coroutine_handle<> handle = readWaiter_;
+    readWaiter_ = nullptr;
+    handle.resume();
+}
+
+void TcpConnection::resumeWriter()
+{
+    std::coroutine_handle<> handle = writeWaiter_;
+    writeWaiter_ = nullptr;
+    handle.resume();
+}
+
+bool TcpConnection::ReadAwaitable::await_ready() const
+{
+    return conn_->inputBuffer_.readableBytes() >= n_ || !conn_->isConnected();
+}
+
+void TcpConnection::ReadAwaitable::await_suspend(std::coroutine_handle<> handle)
+{
+    // 同一时刻一个连接上只能有一个协程在等待读
+    assert(!conn_->readWaiter_);
+    conn_->readWaiter_ = handle;
+    conn_->readWanted_ = n_;
+}
+
+std::string TcpConnection::ReadAwaitable::await_resume()
+{
+    std::size_t n = std::min(n_, conn_->inputBuffer_.readableBytes());
+    return conn_->inputBuffer_.retrieveAsString(n);
+}
+
+bool TcpConnection::WriteAwaitable::await_ready() const
+{
+    return conn_->outputBuffer_.readableBytes() == 0 || !conn_->isConnected();
+}
+
+void TcpConnection::WriteAwaitable::await_suspend(std::coroutine_handle<> handle)
+{
+    assert(!conn_->writeWaiter_);
+    conn_->writeWaiter_ = handle;
+}
+
+bool TcpConnection::WriteAwaitable::await_resume() const
+{
+    return conn_->isConnected();
+}
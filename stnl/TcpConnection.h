@@ -3,6 +3,7 @@
 
 
 #include <memory>
+#include <coroutine>
 #include "Socket.h"
 #include "Channel.h"
 #include "Buffer.h"
@@ -32,6 +33,41 @@ namespace stnl
         using CloseCallback = std::function<void(const TcpConnectionPtr& conn)>;
         using WriteCompletionCallback = std::function<void(const TcpConnectionPtr& conn)>;
 
+        /**
+         * co_await conn->read(n)，等待 inputBuffer_ 中有 n 字节的数据后取出。
+         * 连接关闭时恢复，返回剩余的数据（可能不足 n 字节）。
+         */
+        class ReadAwaitable
+        {
+        public:
+            ReadAwaitable(TcpConnection* conn, std::size_t n): conn_(conn), n_(n) {}
+
+            bool await_ready() const;
+            void await_suspend(std::coroutine_handle<> handle);
+            std::string await_resume();
+
+        private:
+            TcpConnection* conn_;
+            std::size_t n_;
+        };
+
+        /**
+         * co_await conn->write(message)，等待 outputBuffer_ 中的数据全部写入内核。
+         * 返回 false 表示连接已断开。
+         */
+        class WriteAwaitable
+        {
+        public:
+            explicit WriteAwaitable(TcpConnection* conn): conn_(conn) {}
+
+            bool await_ready() const;
+            void await_suspend(std::coroutine_handle<> handle);
+            bool await_resume() const;
+
+        private:
+            TcpConnection* conn_;
+        };
+
 
     public:
         TcpConnection(EventLoop* loop, 
@@ -70,6 +106,13 @@ namespace stnl
         void send(std::string_view message);
         void send(NetBuffer* buf);
 
+        /**
+         * 协程接口，只能在 loop 线程中运行的协程里使用。
+         * 协程在 handleRead/handleWrite/handleClose 中被直接恢复。
+         */
+        ReadAwaitable read(std::size_t n);
+        WriteAwaitable write(std::string_view message);
+
         // void enableRead();
         // void disableRead();
 
@@ -99,6 +142,9 @@ namespace stnl
 
         void forceCloseInLoop();
 
+        void resumeReader();
+        void resumeWriter();
+
     private:
         EventLoop* loop_;
         std::string name_;
@@ -114,6 +160,10 @@ namespace stnl
         MessageCallback messageCallback_;
         CloseCallback closeCallback_;
         WriteCompletionCallback writeCompletionCallback_;
+
+        std::coroutine_handle<> readWaiter_;   // 等待读数据的协程
+        std::size_t readWanted_;
+        std::coroutine_handle<> writeWaiter_;  // 等待 outputBuffer_ 写完的协程
     };
     
     
@@ -90,7 +90,10 @@ TcpServer::TcpServer(const SockAddr& listenAddr,
                     : loop_(new EventLoop()),
                     threadPool_(new EventLoopThreadPool(loop_.get(), name, threadNums)),
                     acceptor_(new Acceptor(loop_.get(), listenAddr)),
-                    name_(name)
+                    name_(name),
+                    nextConnId_(1),
+                    busyPollSeconds_(0.0),
+                    socketBusyPollMicroseconds_(0)
 {
     acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnectionCallback, this, _1, _2));
 }
@@ -110,6 +113,13 @@ TcpServer::~TcpServer()
 void TcpServer::start()
 {
     threadPool_->start();
+    if (busyPollSeconds_ > 0.0)
+    {
+        for (EventLoop *ioLoop : threadPool_->getAllLoops())
+        {
+            ioLoop->setBusyPollDuration(busyPollSeconds_);
+        }
+    }
     loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
     loop_->loop();
 }
@@ -126,11 +136,16 @@ void TcpServer::newConnectionCallback(int socketFd, SockAddr peerAddr)
     loop_->assertInLoopThread();
 
     EventLoop* ioLoop = threadPool_->getNextLoop();
+    if (socketBusyPollMicroseconds_ > 0)
+    {
+        SocketUtil::setBusyPoll(socketFd, socketBusyPollMicroseconds_);
+    }
     SockAddr localAddr(SocketUtil::getLocalAddr(socketFd));
 
-    // 要保证生成的 connections_ 的 key 是唯一的
-    char buf[64];
-    snprintf(buf, sizeof buf, "-%s:%d", peerAddr.ip_str().c_str(), peerAddr.port());
+    // 要保证生成的 connections_ 的 key 是唯一的。
+    // 旧连接从 connections_ 中移除之前，同一个对端地址可能已经建立了新连接，因此加上连接序号
+    char buf[96];
+    snprintf(buf, sizeof buf, "-%s:%d#%lu", peerAddr.ip_str().c_str(), peerAddr.port(), nextConnId_++);
     std::string connectionName = name_ + buf;
 
     TcpConnectionPtr conn(new TcpConnection(ioLoop, connectionName, socketFd, localAddr, peerAddr));
@@ -87,6 +87,16 @@ namespace stnl
             threadPool_->setThreadNums(threadNums);
         }
 
+        /**
+         * 低延迟的忙轮询模式，在 start() 之前调用。
+         * @param spinSeconds 处理连接的 loop 在空闲后继续用 0 超时轮询 epoll 的时间，见 EventLoop::setBusyPollDuration
+         * @param socketBusyPollMicroseconds 大于 0 时为新连接设置 SO_BUSY_POLL/SO_PREFER_BUSY_POLL
+         */
+        void setBusyPoll(double spinSeconds, int socketBusyPollMicroseconds = 0) {
+            busyPollSeconds_ = spinSeconds;
+            socketBusyPollMicroseconds_ = socketBusyPollMicroseconds;
+        }
+
     private:
         /**
          * 新连接到来时的回调函数，传入Acceptor中，acceptor_->setNewConnectionCallback();
@@ -106,9 +116,12 @@ namespace stnl
         std::unique_ptr<Acceptor> acceptor_;
         ConnectionMap connections_;
         std::string name_;
+        unsigned long nextConnId_;      // 只在主 loop 线程中使用
         TcpConnection::ConnectionCallback connectionCallback_;
         TcpConnection::MessageCallback messageCallback_;
         TcpConnection::WriteCompletionCallback writeCompletionCallback_;
+        double busyPollSeconds_;
+        int socketBusyPollMicroseconds_;
     };
 
 }
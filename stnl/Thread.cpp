@@ -1,12 +1,82 @@
 #include "Thread.h"
 
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstdio>
+#include <algorithm>
+
 using namespace stnl;
 
+namespace
+{
+    thread_local int t_tid = 0;
+    thread_local std::string t_name;
+    thread_local char t_logId[64];
+    thread_local size_t t_logIdLength = 0;
+
+    void cacheLogId()
+    {
+        int n = t_name.empty() ? snprintf(t_logId, sizeof(t_logId), "%d", CurrentThread::tid())
+                               : snprintf(t_logId, sizeof(t_logId), "%d/%s", CurrentThread::tid(), t_name.c_str());
+        t_logIdLength = std::min(static_cast<size_t>(n), sizeof(t_logId) - 1);
+    }
+
+    /* fork 后子进程中的线程 id 与父进程不同，清除缓存 */
+    void afterForkInChild()
+    {
+        t_tid = 0;
+        t_logIdLength = 0;
+    }
+
+    struct ForkInitializer
+    {
+        ForkInitializer()
+        {
+            pthread_atfork(nullptr, nullptr, &afterForkInChild);
+        }
+    };
+
+    ForkInitializer forkInitializer;
+}
+
+int CurrentThread::tid()
+{
+    if (t_tid == 0)
+    {
+        t_tid = static_cast<int>(::syscall(SYS_gettid));
+    }
+    return t_tid;
+}
+
+const std::string &CurrentThread::name()
+{
+    return t_name;
+}
+
+void CurrentThread::setName(std::string_view name)
+{
+    t_name = name;
+    t_logIdLength = 0;
+}
+
+std::string_view CurrentThread::logId()
+{
+    if (t_logIdLength == 0)
+    {
+        cacheLogId();
+    }
+    return std::string_view(t_logId, t_logIdLength);
+}
+
 void Thread::threadFuncWarper(ThreadFunction func)
 {
+    // notify 之后 Thread 对象可能已被析构，在此之前读取 threadName_
+    CurrentThread::setName(threadName_);
+
     {
         std::unique_lock<std::mutex> locker(mutex_);
-        tid_ = thread_.get_id();  
+        tid_ = std::this_thread::get_id();
     }
     cv_.notify_one();
 
@@ -16,6 +16,24 @@
 namespace stnl
 {
 
+/**
+ * 当前线程的 id 与名称，首次使用时缓存在 thread_local 变量中，之后不再有系统调用。
+ * 每一行日志都会输出当前线程的标识。
+ */
+namespace CurrentThread
+{
+    /* gettid() 返回的线程 id */
+    int tid();
+
+    /* stnl::Thread 创建的线程为 Thread::name()，其他线程为空 */
+    const std::string& name();
+
+    void setName(std::string_view name);
+
+    /* 日志中的线程标识："tid" 或 "tid/name" */
+    std::string_view logId();
+}
+
 class Thread
 {
 public:
@@ -41,8 +59,9 @@ public:
         thread_ = std::move(std::thread(&Thread::threadFuncWarper, this, std::move(func_)));
         
         {
+            // 等待新线程设置好 tid_，使用谓词避免新线程先 notify 导致的唤醒丢失
             std::unique_lock<std::mutex> locker(mutex_);
-            cv_.wait(locker);
+            cv_.wait(locker, [this]() { return tid_ != std::thread::id(); });
         }
     }
 
@@ -0,0 +1,208 @@
+#include "ThreadPool.h"
+#include "logger.h"
+
+#include <random>
+#include <cstdio>
+
+using namespace stnl;
+
+namespace
+{
+    /* 当前线程所属的线程池以及在线程池中的下标，非工作线程为 nullptr/-1 */
+    thread_local ThreadPool *t_pool = nullptr;
+    thread_local int t_workerIndex = -1;
+}
+
+ThreadPool::ThreadPool(std::string_view name, int threadNums)
+    : name_(name),
+      threadNums_(threadNums > 0 ? threadNums : 1),
+      running_(false),
+      nextQueue_(0),
+      pendingTasks_(0),
+      idleWorkers_(0)
+{
+    for (int i = 0; i < threadNums_; ++i)
+    {
+        queues_.emplace_back(new WorkQueue());
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    if (running_)
+    {
+        stop();
+    }
+}
+
+void ThreadPool::start()
+{
+    assert(!running_);
+    running_ = true;
+    for (int i = 0; i < threadNums_; ++i)
+    {
+        char threadName[name_.size() + 36];
+        snprintf(threadName, sizeof(threadName), "%s - %d", name_.c_str(), i);
+        threads_.emplace_back(new Thread(threadName, std::bind(&ThreadPool::workerFunc, this, i)));
+        threads_.back()->start();
+    }
+}
+
+void ThreadPool::stop()
+{
+    {
+        std::unique_lock<std::mutex> locker(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+
+    for (auto &thread : threads_)
+    {
+        thread->join();
+    }
+    threads_.clear();
+}
+
+void ThreadPool::post(Task task)
+{
+    int index;
+    if (t_pool == this)
+    {
+        // 工作线程中提交的任务放入自己的队列
+        index = t_workerIndex;
+    }
+    else
+    {
+        index = static_cast<int>(nextQueue_.fetch_add(1, std::memory_order_relaxed) % threadNums_);
+    }
+
+    {
+        WorkQueue &queue = *queues_[index];
+        std::unique_lock<std::mutex> locker(queue.mutex);
+        queue.tasks.emplace_back(std::move(task));
+    }
+
+    pendingTasks_.fetch_add(1);
+    if (idleWorkers_.load() > 0)
+    {
+        wakeupWorker();
+    }
+}
+
+void ThreadPool::wakeupWorker()
+{
+    /*
+        加锁保证：若工作线程已经判断过 pendingTasks_ 为 0，那么它此时已经在 cv_ 上等待，
+        不会错过这一次唤醒。
+    */
+    {
+        std::unique_lock<std::mutex> locker(mutex_);
+    }
+    cv_.notify_one();
+}
+
+bool ThreadPool::takeTask(int index, Task &task)
+{
+    {
+        WorkQueue &queue = *queues_[index];
+        std::unique_lock<std::mutex> locker(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // 随机选择一个起始位置，依次尝试从其他队列的头部窃取任务
+    thread_local std::minstd_rand random(static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+    int start = static_cast<int>(random() % threadNums_);
+    for (int i = 0; i < threadNums_; ++i)
+    {
+        int victim = (start + i) % threadNums_;
+        if (victim == index)
+        {
+            continue;
+        }
+
+        WorkQueue &queue = *queues_[victim];
+        std::unique_lock<std::mutex> locker(queue.mutex, std::try_to_lock);
+        if (locker.owns_lock() && !queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::runTask(Task &task)
+{
+    // 任务抛出的异常不能结束工作线程
+    try
+    {
+        task();
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << "ThreadPool " << name_ << " task exception: " << e.what();
+    }
+    catch (...)
+    {
+        LOG_ERROR << "ThreadPool " << name_ << " task unknown exception";
+    }
+}
+
+void ThreadPool::workerFunc(int index)
+{
+    t_pool = this;
+    t_workerIndex = index;
+
+    Task task;
+    int failedAttempts = 0;
+    while (true)
+    {
+        if (pendingTasks_.load() > 0)
+        {
+            if (takeTask(index, task))
+            {
+                failedAttempts = 0;
+                pendingTasks_.fetch_sub(1);
+                runTask(task);
+                task = nullptr;
+            }
+            else if (++failedAttempts < MaxStealAttempts)
+            {
+                // 任务正在被其他线程取走，或者窃取时队列被占用，让出 CPU 后重试
+                std::this_thread::yield();
+            }
+            else
+            {
+                // 多次取不到任务时不再自旋，在 cv_ 上等待新任务的唤醒，超时后再尝试窃取
+                failedAttempts = 0;
+                std::unique_lock<std::mutex> locker(mutex_);
+                if (running_)
+                {
+                    ++idleWorkers_;
+                    cv_.wait_for(locker, std::chrono::milliseconds(1));
+                    --idleWorkers_;
+                }
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> locker(mutex_);
+        if (!running_ && pendingTasks_.load() == 0)
+        {
+            break;
+        }
+        ++idleWorkers_;
+        cv_.wait(locker, [this]() { return !running_ || pendingTasks_.load() > 0; });
+        --idleWorkers_;
+    }
+
+    t_pool = nullptr;
+    t_workerIndex = -1;
+}
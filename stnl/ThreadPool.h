@@ -0,0 +1,127 @@
+#ifndef STNL_THREADPOOL_H
+#define STNL_THREADPOOL_H
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <atomic>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+#include "noncopyable.h"
+#include "Thread.h"
+#include "EventLoop.h"
+
+namespace stnl
+{
+
+    /**
+     * @brief 用于执行计算密集型任务的线程池，避免在 IO 线程（EventLoop）中执行耗时的计算。
+     *
+     * 每个工作线程拥有自己的任务队列（deque）：
+     * 1. 工作线程提交的任务放入自己队列的尾部，并从尾部取任务（LIFO，缓存友好）；
+     * 2. 外部线程提交的任务轮流放入各个工作线程的队列；
+     * 3. 工作线程自己的队列为空时，随机选择其他工作线程，从其队列头部窃取任务。
+     *
+     * 每个队列有各自的锁，不存在所有线程共同竞争的全局任务队列。
+     */
+    class ThreadPool : public noncopyable
+    {
+    public:
+        using Task = std::function<void()>;
+
+        ThreadPool(std::string_view name, int threadNums);
+
+        ~ThreadPool();
+
+        void start();
+
+        /**
+         * 等待已提交的任务执行完后退出所有工作线程
+         */
+        void stop();
+
+        int threadNums() const { return threadNums_; }
+
+        /**
+         * 提交一个不关心返回值的任务
+         */
+        void post(Task task);
+
+        /**
+         * 提交任务，通过 std::future 获取结果
+         */
+        template <typename Func>
+        auto submit(Func &&func) -> std::future<std::invoke_result_t<Func>>
+        {
+            using Result = std::invoke_result_t<Func>;
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+            std::future<Result> future = task->get_future();
+            post([task]() { (*task)(); });
+            return future;
+        }
+
+        /**
+         * 在线程池中执行 func，执行完毕后通过 runInLoop 把结果交给 loop 线程中的 callback。
+         * 通常 loop 为调用者所在的 EventLoop，即结果回到发起计算的 IO 线程。
+         */
+        template <typename Func, typename Callback>
+        void submit(EventLoop *loop, Func &&func, Callback &&callback)
+        {
+            using Result = std::invoke_result_t<Func>;
+            post([loop, func = std::forward<Func>(func), callback = std::forward<Callback>(callback)]() mutable {
+                if constexpr (std::is_void_v<Result>)
+                {
+                    func();
+                    loop->runInLoop(std::move(callback));
+                }
+                else
+                {
+                    loop->runInLoop([callback = std::move(callback), result = func()]() mutable {
+                        callback(std::move(result));
+                    });
+                }
+            });
+        }
+
+    private:
+        /* pendingTasks_ > 0 但连续取不到任务的次数超过该值后，工作线程在 cv_ 上等待 */
+        static const int MaxStealAttempts = 64;
+
+        struct WorkQueue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void workerFunc(int index);
+
+        /**
+         * 先从自己的队列中取任务，取不到则随机从其他队列中窃取
+         */
+        bool takeTask(int index, Task &task);
+
+        void runTask(Task &task);
+
+        void wakeupWorker();
+
+    private:
+        std::string name_;
+        const int threadNums_;
+        std::vector<std::unique_ptr<WorkQueue>> queues_;
+        std::vector<std::unique_ptr<Thread>> threads_;
+        std::atomic_bool running_;
+        std::atomic_uint32_t nextQueue_;
+
+        std::atomic_int64_t pendingTasks_;  // 所有队列中尚未被取走的任务数量
+        std::atomic_int idleWorkers_;       // 正在等待任务的工作线程数量
+        std::mutex mutex_;
+        std::condition_variable cv_;
+    };
+
+}
+
+#endif
@@ -1,6 +1,14 @@
 #include "logger.h"
 #include <assert.h>
 #include <iomanip>
+#include <algorithm>
+#include <charconv>
+#include <type_traits>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 namespace stnl
 {
@@ -23,6 +31,19 @@ namespace stnl
 
     /* --------------------- Logger ----------------------------- */
 
+    std::atomic<LogLevel> Logger::minLogLevel_(LogLevel::INFO);
+    std::atomic_bool Logger::useLoopClock_(false);
+
+    void Logger::setUseLoopClock(bool on)
+    {
+        useLoopClock_.store(on, std::memory_order_relaxed);
+    }
+
+    void Logger::setLogLevel(LogLevel logLevel)
+    {
+        minLogLevel_.store(logLevel, std::memory_order_relaxed);
+    }
+
     Logger::Logger(std::string_view loggerName) : loggerName_(loggerName) {}
 
     Logger &Logger::instance()
@@ -45,6 +66,10 @@ namespace stnl
     {
         // FIXME: key已存在的情况怎么处理
         handlers_.emplace(handler->name(), handler);
+        if (handler->logLevel() < logLevel())
+        {
+            setLogLevel(handler->logLevel());
+        }
     }
 
     void Logger::delHandler(std::string_view name)
@@ -57,7 +82,7 @@ namespace stnl
         handlers_.erase(iter);
     }
 
-    void Logger::write(const LogContextPtr &context)
+    void Logger::write(const LogContext &context)
     {
         if (asyncLogger_)
         {
@@ -69,7 +94,7 @@ namespace stnl
         }
     }
 
-    void Logger::handlerWrite(const LogContextPtr &context)
+    void Logger::handlerWrite(const LogContext &context)
     {
         // 若没有设置LogHandler,则添加一个ConsoleHandler作为默认的LogHandler
         if (handlers_.empty())
@@ -86,52 +111,262 @@ namespace stnl
     void Logger::setAsyncLogger(const std::shared_ptr<AsyncLogging> &asyncLogger)
     {
         asyncLogger_ = asyncLogger;
+        if (asyncLogger_ && asyncLogger_->logLevel() < logLevel())
+        {
+            setLogLevel(asyncLogger_->logLevel());
+        }
     }
 
     /* --------------- LogContenxt ---------------------*/
 
-    LogContext::LogContext(std::string_view sourceFilename, std::string funcname, int line, LogLevel logLevel) : logLevel_(logLevel)
+    namespace
+    {
+        const char Digits[] = "9876543210123456789";
+        const char *Zero = Digits + 9;
+        const char HexDigits[] = "0123456789abcdef";
+
+        /* 每个线程复用同一个 LogContext 格式化日志消息 */
+        thread_local LogContext t_logContext;
+
+        /* EventLoop 缓存的时钟，微秒 */
+        thread_local int64_t t_threadClock = 0;
+
+        /**
+         * @brief 格式化后的 "YYYYMMDD HH:MM:SS"，秒数变化时才重新调用 gmtime_r、strftime
+         */
+        struct TimeCache
+        {
+            time_t seconds;
+            char text[18];
+        };
+
+        thread_local TimeCache t_timeCache = {-1, {0}};
+
+        /**
+         * @brief 整数转字符串，逐位取余数后翻转，负数的余数同样可以通过 Zero 索引到正确的字符
+         */
+        template <typename T>
+        size_t convert(char buf[], T value)
+        {
+            T i = value;
+            char *p = buf;
+
+            do
+            {
+                int lsd = static_cast<int>(i % 10);
+                i /= 10;
+                *p++ = Zero[lsd];
+            } while (i != 0);
+
+            if constexpr (std::is_signed_v<T>)
+            {
+                if (value < 0)
+                {
+                    *p++ = '-';
+                }
+            }
+            *p = '\0';
+            std::reverse(buf, p);
+
+            return p - buf;
+        }
+
+        size_t convertHex(char buf[], uintptr_t value)
+        {
+            uintptr_t i = value;
+            char *p = buf;
+
+            do
+            {
+                int lsd = static_cast<int>(i % 16);
+                i /= 16;
+                *p++ = HexDigits[lsd];
+            } while (i != 0);
+
+            *p = '\0';
+            std::reverse(buf, p);
+
+            return p - buf;
+        }
+    }
+
+    LogContext::LogContext() : threadId_(0), logLevel_(LogLevel::INFO), timestamp_(0), inUse_(false), overflowed_(false), length_(0)
+    {
+    }
+
+    int64_t LogContext::now()
     {
-        if (logLevel == LogLevel::FATAL)
+        if (t_threadClock != 0 && Logger::useLoopClock())
         {
+            return t_threadClock;
         }
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        return static_cast<int64_t>(tv.tv_sec) * 1000 * 1000 + tv.tv_usec;
+    }
+
+    void LogContext::setThreadClock(int64_t microSecondsSinceEpoch)
+    {
+        t_threadClock = microSecondsSinceEpoch;
+    }
+
+    void LogContext::begin(const char *sourceFilename, const char *funcname, int line, LogLevel logLevel)
+    {
+        begin(sourceFilename, funcname, line, logLevel, now());
+    }
 
-        struct timeval tv_;
-        gettimeofday(&tv_, nullptr);
+    void LogContext::begin(const char *sourceFilename, const char *funcname, int line, LogLevel logLevel, int64_t timestamp)
+    {
+        begin(sourceFilename, funcname, line, logLevel, timestamp, CurrentThread::tid(), CurrentThread::logId());
+    }
 
-        char timeBuffer[18];
-        formatTime(tv_, timeBuffer, sizeof(timeBuffer));
-        *this << timeBuffer << ' ';
-        *this << std::setw(6) << std::setfill('0') << tv_.tv_usec;
-        *this << ' ' << LogLevelName[logLevel] << ' ';
+    void LogContext::begin(const char *sourceFilename, const char *funcname, int line, LogLevel logLevel, int64_t timestamp,
+                           int threadId, std::string_view threadLogId)
+    {
+        inUse_ = true;
+        threadId_ = threadId;
+        overflowed_ = false;
+        length_ = 0;
+        logLevel_ = logLevel;
+        timestamp_ = timestamp;
+
+        struct timeval tv;
+        tv.tv_sec = static_cast<time_t>(timestamp / (1000 * 1000));
+        tv.tv_usec = static_cast<suseconds_t>(timestamp % (1000 * 1000));
+
+        if (tv.tv_sec != t_timeCache.seconds)
+        {
+            t_timeCache.seconds = tv.tv_sec;
+            formatTime(tv, t_timeCache.text, sizeof(t_timeCache.text));
+        }
+        append(t_timeCache.text, 17);
 
-        const char *filename = strrchr(sourceFilename.data(), '/');
-        if (filename)
+        // 微秒固定输出 6 位，不足补 0
+        char usec[8] = {' ', '0', '0', '0', '0', '0', '0', ' '};
+        for (int i = 6, value = static_cast<int>(tv.tv_usec); i > 0 && value > 0; --i, value /= 10)
         {
-            *this << filename + 1 << ' ';
+            usec[i] = static_cast<char>('0' + value % 10);
         }
+        append(usec, sizeof(usec));
+
+        *this << threadLogId << ' ' << LogLevelName[logLevel] << ' ';
+
+        const char *filename = strrchr(sourceFilename, '/');
+        *this << (filename ? filename + 1 : sourceFilename) << ' ';
 
         *this << funcname << ' ' << line << " | ";
+    }
+
+    void LogContext::spill(const char *data, size_t len)
+    {
+        if (!overflowed_)
+        {
+            overflow_.assign(buffer_, length_);
+            overflowed_ = true;
+        }
+        overflow_.append(data, len);
+    }
+
+    std::ostringstream &LogContext::fallbackStream()
+    {
+        thread_local std::ostringstream os;
+        return os;
+    }
+
+    template <typename T>
+    void LogContext::formatInteger(T v)
+    {
+        // 64 位整数最多 20 位数字，加上符号位
+        char buf[32];
+        size_t len = convert(buf, v);
+        append(buf, len);
+    }
 
-        // @todo 获取线程id
+    LogContext &LogContext::operator<<(short v)
+    {
+        formatInteger(static_cast<int>(v));
+        return *this;
+    }
+
+    LogContext &LogContext::operator<<(unsigned short v)
+    {
+        formatInteger(static_cast<unsigned int>(v));
+        return *this;
+    }
+
+    LogContext &LogContext::operator<<(int v)
+    {
+        formatInteger(v);
+        return *this;
+    }
+
+    LogContext &LogContext::operator<<(unsigned int v)
+    {
+        formatInteger(v);
+        return *this;
+    }
+
+    LogContext &LogContext::operator<<(long v)
+    {
+        formatInteger(v);
+        return *this;
+    }
+
+    LogContext &LogContext::operator<<(unsigned long v)
+    {
+        formatInteger(v);
+        return *this;
+    }
+
+    LogContext &LogContext::operator<<(long long v)
+    {
+        formatInteger(v);
+        return *this;
+    }
+
+    LogContext &LogContext::operator<<(unsigned long long v)
+    {
+        formatInteger(v);
+        return *this;
+    }
+
+    LogContext &LogContext::operator<<(double v)
+    {
+        // 与 std::ostream 的默认格式（%g，6 位有效数字）一致，std::to_chars 不依赖 locale，也不分配内存
+        char buf[32];
+        auto result = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::general, 6);
+        append(buf, static_cast<size_t>(result.ptr - buf));
+        return *this;
+    }
+
+    LogContext &LogContext::operator<<(const void *p)
+    {
+        char buf[32];
+        buf[0] = '0';
+        buf[1] = 'x';
+        size_t len = convertHex(buf + 2, reinterpret_cast<uintptr_t>(p));
+        append(buf, len + 2);
+        return *this;
     }
 
     /* --------------------------- LogRecorder --------------------------*/
 
-    LogRecorder::LogRecorder(const std::string_view sourceFilename,
-                             std::string funcname, int line, 
+    LogRecorder::LogRecorder(const char *sourceFilename,
+                             const char *funcname, int line, 
                              LogLevel logLevel, 
                              Logger &logger) : 
-                             context_(new LogContext(sourceFilename, funcname, line, logLevel)), 
+                             nestedContext_(t_logContext.inUse() ? new LogContext() : nullptr),
+                             context_(nestedContext_ ? *nestedContext_ : t_logContext),
                              logger_(logger)
     {
+        context_.begin(sourceFilename, funcname, line, logLevel);
     }
 
     LogRecorder::~LogRecorder()
     {
-        (*this) << "\n";
+        context_ << '\n';
         logger_.write(context_);
-        context_.reset();
+        context_.end();
     }
 
     /* --------------------------- LogHandler --------------------------*/
@@ -145,6 +380,11 @@ namespace stnl
         logLevel_ = LogLevel;
     }
 
+    LogLevel LogHandler::logLevel() const
+    {
+        return logLevel_;
+    }
+
     const std::string &LogHandler::name() const
     {
         return name_;
@@ -154,17 +394,17 @@ namespace stnl
 
     ConsoleHandler::ConsoleHandler(std::string_view name, LogLevel logLevel) : LogHandler(name, logLevel) {}
 
-    void ConsoleHandler::write(const LogContextPtr &context)
+    void ConsoleHandler::write(const LogContext &context)
     {
         // 对小于LogHandler日志级别的日志消息直接忽略
-        if (context->logLevel_ < logLevel_)
+        if (context.logLevel_ < logLevel_)
         {
             return;
         }
 
-        std::cout << context->view();
+        std::cout << context.view();
 
-        if (context->logLevel_ == LogLevel::FATAL)
+        if (context.logLevel_ == LogLevel::FATAL)
         {
             std::cout.flush();
             abort();
@@ -174,6 +414,23 @@ namespace stnl
     /* ------------------------- LogFile -------------------------------- */
 
     LogFile::LogFile(std::string_view filename) : filename_(filename), writtenBytes_(0)
+    {
+    }
+
+    off_t LogFile::writtenBytes() const
+    {
+        return writtenBytes_;
+    }
+
+    void LogFile::append(const LogContext &context)
+    {
+        std::string_view logMessage = context.view();
+        append(logMessage.data(), static_cast<int>(logMessage.size()));
+    }
+
+    /* ------------------------- StdioLogFile -------------------------------- */
+
+    StdioLogFile::StdioLogFile(std::string_view filename) : LogFile(filename)
     {
         /* ae，追加或者为写打开 */
         fp_ = fopen(filename_.c_str(), "ae");
@@ -181,32 +438,24 @@ namespace stnl
         setbuffer(fp_, buffer_, LogFileBufferSize);
     }
 
-    LogFile::~LogFile()
+    StdioLogFile::~StdioLogFile()
     {
         fclose(fp_);
     }
 
-    void LogFile::flush()
+    void StdioLogFile::flush()
     {
         fflush(fp_);
     }
 
-    off_t LogFile::writtenBytes() const
-    {
-        return writtenBytes_;
-    }
-
-    void LogFile::append(const LogContextPtr &context)
+    // @FIXME:
+    void StdioLogFile::append(const char *buf, int len)
     {
-        // @todo 添加线程id信息
-
-        std::string logMessage(context->view());
-
         size_t written = 0;
-        while (written != logMessage.size())
+        while (written != len)
         {
-            size_t remain = logMessage.size() - written;
-            size_t n = fwrite_unlocked(logMessage.data() + written, 1, remain, fp_);
+            size_t remain = len - written;
+            size_t n = fwrite_unlocked(buf + written, 1, remain, fp_);
             if (n != remain)
             {
                 int err = ferror(fp_);
@@ -218,37 +467,274 @@ namespace stnl
             }
             written += n;
         }
-
+        // std::cout << __LINE__ << "written = " << written << " len = " << len << std::endl;
         writtenBytes_ += written;
     }
 
-    // @FIXME:
-    void LogFile::append(const char *buf, int len)
+    /* ------------------------- DirectLogFile -------------------------------- */
+
+    DirectLogFile::DirectLogFile(std::string_view filename)
+        : LogFile(filename), fd_(-1), length_(0), buffer_(new char[BufferSize])
     {
-        size_t written = 0;
-        while (written != len)
+        /* 与 "ae" 相同，每次写入都追加到文件末尾 */
+        fd_ = ::open(filename_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        assert(fd_ >= 0);
+    }
+
+    DirectLogFile::~DirectLogFile()
+    {
+        flush();
+        ::close(fd_);
+    }
+
+    void DirectLogFile::flush()
+    {
+        if (length_ > 0)
         {
-            size_t remain = len - written;
-            size_t n = fwrite_unlocked(buf + written, 1, remain, fp_);
-            if (n != remain)
+            struct iovec iov = {buffer_.get(), length_};
+            writeFully(&iov, 1);
+            length_ = 0;
+        }
+    }
+
+    void DirectLogFile::append(const char *buf, int len)
+    {
+        size_t size = static_cast<size_t>(len);
+        if (length_ + size <= BufferSize)
+        {
+            memcpy(buffer_.get() + length_, buf, size);
+            length_ += size;
+        }
+        else
+        {
+            /* 缓冲区中的数据与新数据一起写出，新数据不经过缓冲区 */
+            struct iovec iov[2];
+            iov[0].iov_base = buffer_.get();
+            iov[0].iov_len = length_;
+            iov[1].iov_base = const_cast<char *>(buf);
+            iov[1].iov_len = size;
+            writeFully(iov, 2);
+            length_ = 0;
+        }
+        writtenBytes_ += size;
+    }
+
+    void DirectLogFile::writeFully(struct iovec *iov, int iovcnt)
+    {
+        while (iovcnt > 0)
+        {
+            ssize_t n = ::writev(fd_, iov, iovcnt);
+            if (n < 0)
             {
-                int err = ferror(fp_);
-                if (err)
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                fprintf(stderr, "LogFile Append failed %s\n", strerror(errno));
+                return;
+            }
+
+            /* 部分写入，跳过已写出的部分 */
+            size_t written = static_cast<size_t>(n);
+            while (iovcnt > 0 && written >= iov->iov_len)
+            {
+                written -= iov->iov_len;
+                ++iov;
+                --iovcnt;
+            }
+            if (iovcnt > 0)
+            {
+                iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+                iov->iov_len -= written;
+            }
+        }
+    }
+
+    /* ------------------------- MappedLogFile -------------------------------- */
+
+    MappedLogFile::MappedLogFile(std::string_view filename, off_t fileSize, int syncInterval)
+        : LogFile(filename), fd_(-1), fileSize_(std::max<off_t>(fileSize, 4096)), fileLength_(0), offset_(0), syncedOffset_(0),
+          window_(nullptr), windowStart_(0), syncInterval_(syncInterval), lastSyncTime_(time(NULL))
+    {
+        fd_ = ::open(filename_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        assert(fd_ >= 0);
+        struct stat st;
+        if (::fstat(fd_, &st) == 0)
+        {
+            fileLength_ = st.st_size;
+            offset_ = dataEnd(fileLength_);
+            syncedOffset_ = offset_;
+        }
+        reserve(offset_ + fileSize_);
+    }
+
+    MappedLogFile::~MappedLogFile()
+    {
+        if (window_)
+        {
+            ::munmap(window_, WindowSize);
+        }
+        /* 去掉预分配但没有使用的部分 */
+        if (::ftruncate(fd_, offset_) < 0)
+        {
+            fprintf(stderr, "LogFile truncate failed %s\n", strerror(errno));
+        }
+        ::close(fd_);
+    }
+
+    void MappedLogFile::append(const char *buf, int len)
+    {
+        size_t remain = static_cast<size_t>(len);
+        while (remain > 0)
+        {
+            if (!window_ || offset_ >= windowStart_ + static_cast<off_t>(WindowSize))
+            {
+                if (!remap(offset_))
                 {
-                    fprintf(stderr, "LogFile Append failed %s\n", strerror(err));
                     break;
                 }
             }
-            written += n;
+            size_t n = std::min(remain, static_cast<size_t>(windowStart_ + WindowSize - offset_));
+            memcpy(window_ + (offset_ - windowStart_), buf, n);
+            offset_ += n;
+            buf += n;
+            remain -= n;
         }
-        // std::cout << __LINE__ << "written = " << written << " len = " << len << std::endl;
-        writtenBytes_ += written;
+        writtenBytes_ += len - remain;
+    }
+
+    void MappedLogFile::flush()
+    {
+        time_t now = time(NULL);
+        if (offset_ == syncedOffset_ || now - lastSyncTime_ < syncInterval_)
+        {
+            return;
+        }
+        lastSyncTime_ = now;
+
+        int ret;
+        if (window_ && syncedOffset_ >= windowStart_)
+        {
+            /* msync 的起始地址需要按页对齐 */
+            off_t start = syncedOffset_ & ~static_cast<off_t>(sysconf(_SC_PAGESIZE) - 1);
+            ret = ::msync(window_ + (start - windowStart_), offset_ - start, MS_SYNC);
+        }
+        else
+        {
+            /* 部分数据所在的窗口已经解除映射 */
+            ret = ::fdatasync(fd_);
+        }
+        if (ret < 0)
+        {
+            fprintf(stderr, "LogFile sync failed %s\n", strerror(errno));
+        }
+        syncedOffset_ = offset_;
+    }
+
+    bool MappedLogFile::remap(off_t offset)
+    {
+        if (window_)
+        {
+            ::munmap(window_, WindowSize);
+            window_ = nullptr;
+        }
+
+        /* WindowSize 是页大小的整数倍，窗口的起始偏移按 WindowSize 对齐 */
+        off_t start = offset / static_cast<off_t>(WindowSize) * static_cast<off_t>(WindowSize);
+        if (!reserve(start + static_cast<off_t>(WindowSize)))
+        {
+            return false;
+        }
+        void *addr = ::mmap(nullptr, WindowSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, start);
+        if (addr == MAP_FAILED)
+        {
+            fprintf(stderr, "LogFile mmap failed %s\n", strerror(errno));
+            return false;
+        }
+        window_ = static_cast<char *>(addr);
+        windowStart_ = start;
+        return true;
+    }
+
+    bool MappedLogFile::reserve(off_t length)
+    {
+        if (length <= fileLength_)
+        {
+            return true;
+        }
+        length = std::max(length, fileLength_ + fileSize_);
+        /* 访问映射中超出文件末尾的部分会产生 SIGBUS，文件系统不支持 fallocate 时退化为 ftruncate */
+        int err = ::fallocate(fd_, 0, fileLength_, length - fileLength_) < 0 ? errno : 0;
+        if (err == EOPNOTSUPP || err == EINVAL)
+        {
+            err = ::ftruncate(fd_, length) < 0 ? errno : 0;
+        }
+        if (err != 0)
+        {
+            fprintf(stderr, "LogFile allocate failed %s\n", strerror(err));
+            return false;
+        }
+        fileLength_ = length;
+        return true;
+    }
+
+    off_t MappedLogFile::dataEnd(off_t fileLength) const
+    {
+        /*
+            有效数据是文件的前缀，之后全是预分配的 0，而日志文本中不会出现整块的 0。
+            按块二分查找第一个全 0 的块，预分配的部分再大也只需要 O(log n) 次 pread。
+        */
+        static const off_t BlockSize = 4096;
+        char buf[BlockSize];
+        auto readBlock = [this, fileLength, &buf](off_t block) -> ssize_t {
+            off_t start = block * BlockSize;
+            size_t len = static_cast<size_t>(std::min(BlockSize, fileLength - start));
+            ssize_t n = ::pread(fd_, buf, len, start);
+            return n == static_cast<ssize_t>(len) ? n : -1;
+        };
+
+        off_t low = 0;
+        off_t high = (fileLength + BlockSize - 1) / BlockSize;
+        while (low < high)
+        {
+            off_t mid = low + (high - low) / 2;
+            ssize_t n = readBlock(mid);
+            if (n < 0)
+            {
+                return fileLength;
+            }
+            if (buf[0] == '\0' && memcmp(buf, buf + 1, n - 1) == 0)
+            {
+                high = mid;
+            }
+            else
+            {
+                low = mid + 1;
+            }
+        }
+        if (low == 0)
+        {
+            return 0;
+        }
+
+        /* 最后一个有数据的块中，最后一个非 0 字节之后 */
+        ssize_t n = readBlock(low - 1);
+        if (n < 0)
+        {
+            return fileLength;
+        }
+        while (n > 0 && buf[n - 1] == '\0')
+        {
+            --n;
+        }
+        return (low - 1) * BlockSize + n;
     }
 
     /* --------------------------- FileHandler ---------------------------------- */
 
     FileHandler::FileHandler(std::string_view name, LogLevel logLevel, std::string_view filepath,
-                             int flushInterval, int flushEveryNLine, int fileRollSize, bool threadSafe) : LogHandler(name, logLevel), filepath_(filepath), flushInterval_(flushInterval),
+                             int flushInterval, int flushEveryNLine, int fileRollSize, bool threadSafe, LogFileType fileType)
+        : LogHandler(name, logLevel), filepath_(filepath), fileType_(fileType), flushInterval_(flushInterval),
                                                                                                           flushEveryNLine_(flushEveryNLine), fileRollSize_(fileRollSize), lineCount_(0),
                                                                                                           lastRollTime_(0), lastFlushTime_(0), lastRollPeriod_(0), mutex_(threadSafe ? new std::mutex() : nullptr)
     {
@@ -277,7 +763,9 @@ namespace stnl
              这一步可以进行优化改进吗？不使用智能指针管理 LogFile 对象。
              复用同一块 buffer，绑定行的文件流，即绑定一个新的 FILE 对象。
             */
-            logFile_.reset(new LogFile(filename));
+            /* 新文件可能与当前文件同名，先关闭当前文件，写出缓冲的数据后再打开 */
+            logFile_.reset();
+            logFile_.reset(newLogFile(filename));
 
             return true;
         }
@@ -285,6 +773,19 @@ namespace stnl
         return false;
     }
 
+    LogFile *FileHandler::newLogFile(const std::string &filename) const
+    {
+        switch (fileType_)
+        {
+        case LogFileType::Direct:
+            return new DirectLogFile(filename);
+        case LogFileType::Mmap:
+            return new MappedLogFile(filename, fileRollSize_, flushInterval_);
+        default:
+            return new StdioLogFile(filename);
+        }
+    }
+
     std::string FileHandler::getFilename(std::string_view filepath, time_t &now)
     {
         /**
@@ -301,9 +802,9 @@ namespace stnl
         return filename;
     }
 
-    void FileHandler::write(const LogContextPtr &context)
+    void FileHandler::write(const LogContext &context)
     {
-        if (context->logLevel_ < logLevel_)
+        if (context.logLevel_ < logLevel_)
         {
             return;
         }
@@ -319,14 +820,14 @@ namespace stnl
             append(context);
         }
 
-        if (context->logLevel_ == LogLevel::FATAL)
+        if (context.logLevel_ == LogLevel::FATAL)
         {
             flush();
             abort();
         }
     }
 
-    void FileHandler::append(const LogContextPtr &context)
+    void FileHandler::append(const LogContext &context)
     {
         logFile_->append(context);
 
@@ -381,15 +882,117 @@ namespace stnl
 
     /* -------------------------------- AsyncLogging ------------------------------- */
 
+    /**
+     * @brief 单个线程的日志缓冲区，单生产者（写日志的线程）单消费者（后端线程）的字节环形缓冲区。
+     * 每条日志以 RecordHeader 开头，后面紧跟日志内容，记录可以跨越缓冲区末尾。
+     * 缓冲区在写日志的线程中创建，同时记录该线程的标识。
+     * writeIndex、readIndex 单调递增，取模后得到在 data 中的位置。
+     */
+    struct AsyncThreadBuffer
+    {
+        enum RecordType : uint32_t
+        {
+            TextRecord = 0,     /* 已格式化的日志消息 */
+            BinaryRecord,       /* const LogSite* + LogDecodeFunc + 参数的原始字节 */
+        };
+
+        struct RecordHeader
+        {
+            uint32_t length;
+            uint32_t type;
+            int64_t timestamp;
+        };
+
+        explicit AsyncThreadBuffer(size_t size)
+            : data(new char[size]), capacity(size), mask(size - 1), writeIndex(0), readIndex(0), producerAlive(true), consumerAlive(true),
+              threadId(CurrentThread::tid()), threadLogId(CurrentThread::logId())
+        {
+            assert((size & mask) == 0);
+            for (auto &count : droppedLines)
+            {
+                count = 0;
+            }
+        }
+
+        void copyIn(uint64_t index, const void *src, size_t len)
+        {
+            size_t offset = index & mask;
+            size_t first = std::min(len, capacity - offset);
+            memcpy(data.get() + offset, src, first);
+            memcpy(data.get(), static_cast<const char *>(src) + first, len - first);
+        }
+
+        void copyOut(uint64_t index, void *dst, size_t len) const
+        {
+            size_t offset = index & mask;
+            size_t first = std::min(len, capacity - offset);
+            memcpy(dst, data.get() + offset, first);
+            memcpy(static_cast<char *>(dst) + first, data.get(), len - first);
+        }
+
+        RecordHeader header(uint64_t index) const
+        {
+            RecordHeader h;
+            copyOut(index, &h, sizeof(h));
+            return h;
+        }
+
+        std::unique_ptr<char[]> data;
+        const size_t capacity;
+        const size_t mask;
+        alignas(64) std::atomic<uint64_t> writeIndex;   /* 只由生产者修改 */
+        alignas(64) std::atomic<uint64_t> readIndex;    /* 只由后端线程修改 */
+        std::atomic_bool producerAlive;                 /* 写日志的线程已退出时为 false */
+        std::atomic_bool consumerAlive;                 /* AsyncLogging 已析构时为 false */
+        const int threadId;                             /* 写日志的线程，后端线程格式化二进制日志时使用 */
+        const std::string threadLogId;
+        std::atomic<uint64_t> droppedLines[LogLevel::NUM_LOG_LEVELS];  /* 只由生产者修改 */
+    };
+
+    namespace
+    {
+        std::atomic<uint64_t> g_asyncLoggingId(0);
+
+        /* 尚未写出的 LargeRecord 的总大小上限，超过后按 OverflowPolicy 等待或丢弃 */
+        const size_t MaxLargeRecordBytes = 16 * 1024 * 1024;
+
+        size_t roundUpPowerOfTwo(size_t size)
+        {
+            // 至少能容纳一条最大的二进制日志（LogBinaryMaxArgsSize）作为普通记录
+            size_t n = 16 * 1024;
+            while (n < size)
+            {
+                n <<= 1;
+            }
+            return n;
+        }
+
+        /**
+         * @brief 当前线程在各个 AsyncLogging 中的缓冲区，线程退出时通知后端线程回收
+         */
+        struct ThreadBufferCache
+        {
+            ~ThreadBufferCache()
+            {
+                for (auto &entry : entries)
+                {
+                    entry.second->producerAlive = false;
+                }
+            }
+
+            std::vector<std::pair<uint64_t, AsyncLogging::ThreadBufferPtr>> entries;
+        };
+
+        thread_local ThreadBufferCache t_threadBuffers;
+    }
+
     AsyncLogging::AsyncLogging(std::string_view logFilepath, LogLevel logLevel, int fileRollSize,
-                               int flushInterval, int flushEveryNLine) : logFilepath_(logFilepath), fileRollSize_(fileRollSize),
-                                                                         logLevel_(logLevel), flushEveryNLine_(flushEveryNLine),
-                                                                         running_(false), currentBuffer_(new Buffer(AsyncBufferSize)), latch_(1), flushInterval_(flushInterval),
-                                                                         nextBuffer_(new Buffer(AsyncBufferSize)), thread_("AsyncLogging", std::bind(&AsyncLogging::run, this))
+                               int flushInterval, int flushEveryNLine, size_t threadBufferSize)
+        : id_(++g_asyncLoggingId), running_(false), logFilepath_(logFilepath), fileRollSize_(fileRollSize),
+          threadBufferSize_(roundUpPowerOfTwo(threadBufferSize)), threadBuffersChanged_(false), wakeupPending_(false),
+          largeRecordBytes_(0), overflowPolicy_(OverflowPolicy::Block), keepLevel_(LogLevel::WARN), retiredDroppedLines_{0}, latch_(1), blockedProducers_(0), thread_("AsyncLogging", std::bind(&AsyncLogging::run, this)), logLevel_(logLevel),
+          flushInterval_(flushInterval), flushEveryNLine_(flushEveryNLine), fileType_(LogFileType::Stdio)
     {
-        currentBuffer_->clear();
-        nextBuffer_->clear();
-        buffers_.reserve(16);
     }
 
     AsyncLogging::~AsyncLogging()
@@ -398,6 +1001,44 @@ namespace stnl
         {
             stop();
         }
+
+        std::unique_lock<std::mutex> locker(mutex_);
+        for (auto &buffer : threadBuffers_)
+        {
+            buffer->consumerAlive = false;
+        }
+    }
+
+    void AsyncLogging::setOverflowPolicy(OverflowPolicy policy, LogLevel keepLevel)
+    {
+        keepLevel_ = keepLevel;
+        overflowPolicy_ = policy;
+    }
+
+    void AsyncLogging::setLogFileType(LogFileType fileType)
+    {
+        fileType_ = fileType;
+    }
+
+    uint64_t AsyncLogging::droppedLines(LogLevel logLevel) const
+    {
+        std::unique_lock<std::mutex> locker(mutex_);
+        uint64_t count = retiredDroppedLines_[logLevel];
+        for (const auto &buffer : threadBuffers_)
+        {
+            count += buffer->droppedLines[logLevel].load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    uint64_t AsyncLogging::droppedLines() const
+    {
+        uint64_t count = 0;
+        for (int level = 0; level < LogLevel::NUM_LOG_LEVELS; ++level)
+        {
+            count += droppedLines(static_cast<LogLevel>(level));
+        }
+        return count;
     }
 
     void AsyncLogging::start()
@@ -410,123 +1051,391 @@ namespace stnl
 
     void AsyncLogging::stop()
     {
-        running_ = false;
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            running_ = false;
+        }
         cv_.notify_all();
+        notFull_.notify_all();
         thread_.join();
     }
 
-    void AsyncLogging::run()
+    void AsyncLogging::wakeup()
     {
-        assert(running_ == true);
-        latch_.countDown();
-        FileHandler output("AsyncLogging-FileHandler", logLevel_, logFilepath_, flushInterval_, flushEveryNLine_, fileRollSize_);
-        BufferPtr newBuffer1(new Buffer(AsyncBufferSize));
-        BufferPtr newBuffer2(new Buffer(AsyncBufferSize));
-        newBuffer1->clear();
-        newBuffer1->clear();
-        BufferVector buffersToWrite;
-        buffersToWrite.reserve(16);
-        while (running_)
+        // 持有锁通知，避免与后端线程检查 wakeupPending_ 之间的唤醒丢失
+        if (!wakeupPending_.exchange(true))
         {
-            assert(newBuffer1 && newBuffer1->size() == 0);
-            assert(newBuffer2 && newBuffer2->size() == 0);
-            assert(buffersToWrite.empty());
+            std::unique_lock<std::mutex> locker(mutex_);
+            cv_.notify_one();
+        }
+    }
 
+    void AsyncLogging::waitForSpace(const std::function<bool()> &hasSpace)
+    {
+        wakeup();
+        std::unique_lock<std::mutex> locker(mutex_);
+        ++blockedProducers_;
+        // 与 notifyNotFull() 中的 fence 配对：要么后端线程看到 blockedProducers_，要么这里看到腾出的空间
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        notFull_.wait(locker, [this, &hasSpace]() { return !running_ || hasSpace(); });
+        --blockedProducers_;
+    }
+
+    void AsyncLogging::notifyNotFull()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (blockedProducers_.load(std::memory_order_relaxed) > 0)
+        {
             {
                 std::unique_lock<std::mutex> locker(mutex_);
-                if (buffers_.empty())
-                {
-                    // std::cout << __LINE__ << "后端buffer为空，等待buffer交换" << std::endl;
+            }
+            notFull_.notify_all();
+        }
+    }
 
-                    // flushInterval_ 时间间隔过后，即使前端线程的buffer还没有写满，
-                    // 仍然将未写满的buffer与后端进行交换，以保证及时写日志。
-                    cv_.wait_for(locker, std::chrono::seconds(flushInterval_));
-                }
-                buffers_.push_back(std::move(currentBuffer_));
-                currentBuffer_ = std::move(newBuffer1);
-                buffersToWrite.swap(buffers_);
-                if (!nextBuffer_)
-                {
-                    nextBuffer_ = std::move(newBuffer2);
-                }
+    AsyncThreadBuffer *AsyncLogging::threadBuffer()
+    {
+        auto &entries = t_threadBuffers.entries;
+        for (auto &entry : entries)
+        {
+            if (entry.first == id_)
+            {
+                return entry.second.get();
             }
+        }
 
-            assert(!buffersToWrite.empty());
+        // 顺便清理已析构的 AsyncLogging 留下的缓冲区
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [](const auto &entry) { return !entry.second->consumerAlive; }),
+                      entries.end());
 
-            // FIXME:
-            if (buffersToWrite.size() > 25)
-            {
-                struct timeval tv_;
-                gettimeofday(&tv_, nullptr);
+        ThreadBufferPtr buffer = std::make_shared<AsyncThreadBuffer>(threadBufferSize_);
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            threadBuffers_.push_back(buffer);
+            threadBuffersChanged_ = true;
+        }
+        entries.emplace_back(id_, buffer);
+        return buffer.get();
+    }
+
+    void AsyncLogging::append(const LogContext &context)
+    {
+        if (context.logLevel_ < logLevel_)
+        {
+            return;
+        }
 
-                char timeBuffer[18];
-                formatTime(tv_, timeBuffer, sizeof(timeBuffer));
+        std::string_view line = context.view();
+        appendRecord(AsyncThreadBuffer::TextRecord, context.logLevel_, context.timestamp_, line.data(), line.size(), nullptr, 0);
+    }
 
-                std::ostringstream sout;
-                sout << "Dropped log messages at " << timeBuffer << ' ';
-                sout << std::setw(6) << std::setfill('0') << tv_.tv_usec << ' ';
-                sout << buffersToWrite.size() - 2 << " larger buffers\n";
+    void AsyncLogging::appendBinary(const LogSite &site, LogDecodeFunc decode, const char *args, size_t size)
+    {
+        if (site.logLevel < logLevel_)
+        {
+            return;
+        }
 
-                fputs(sout.view().data(), stderr);
-                output.append(sout.view().data(), static_cast<int>(sout.view().size()));
-                buffersToWrite.erase(buffersToWrite.begin() + 2, buffersToWrite.end());
-            }
+        int64_t timestamp = LogContext::now();
 
-            for (const auto &buffer : buffersToWrite)
+        char ids[sizeof(const LogSite *) + sizeof(LogDecodeFunc)];
+        const LogSite *sitePtr = &site;
+        memcpy(ids, &sitePtr, sizeof(sitePtr));
+        memcpy(ids + sizeof(sitePtr), &decode, sizeof(decode));
+        appendRecord(AsyncThreadBuffer::BinaryRecord, site.logLevel, timestamp, ids, sizeof(ids), args, size);
+    }
+
+    bool AsyncLogging::droppable(LogLevel logLevel) const
+    {
+        OverflowPolicy policy = overflowPolicy_.load(std::memory_order_relaxed);
+        return policy == OverflowPolicy::DropNewest ||
+               (policy == OverflowPolicy::DropByLevel && logLevel < keepLevel_.load(std::memory_order_relaxed));
+    }
+
+    void AsyncLogging::appendRecord(uint32_t type, LogLevel logLevel, int64_t timestamp, const char *data1, size_t len1, const char *data2, size_t len2)
+    {
+        AsyncThreadBuffer *buffer = threadBuffer();
+
+        size_t length = len1 + len2;
+        if (length > std::min(buffer->capacity, static_cast<size_t>(AsyncBufferSize)) / 4)
+        {
+            // 二进制日志的参数不超过 LogBinaryMaxArgsSize，不会走到这里
+            if (type == AsyncThreadBuffer::TextRecord)
             {
-                output.append(buffer->begin(), buffer->size());
+                appendLargeRecord(buffer, logLevel, timestamp, data1, len1);
             }
-
-            if (!newBuffer1)
+            else
             {
-                assert(!buffersToWrite.empty());
-                newBuffer1 = std::move(buffersToWrite.back());
-                buffersToWrite.pop_back();
-                newBuffer1->reset();
+                buffer->droppedLines[logLevel].fetch_add(1, std::memory_order_relaxed);
             }
+            return;
+        }
+        size_t recordSize = sizeof(AsyncThreadBuffer::RecordHeader) + length;
+
+        uint64_t writeIndex = buffer->writeIndex.load(std::memory_order_relaxed);
+        bool canDrop = droppable(logLevel);
 
-            if (!newBuffer2)
+        // DropByLevel 提前丢弃低级别的日志，为 keepLevel 及以上的日志预留空间
+        size_t limitUsed = canDrop && overflowPolicy_ == OverflowPolicy::DropByLevel ? buffer->capacity / 4 * 3 : buffer->capacity;
+        auto hasSpace = [buffer, writeIndex, recordSize, limitUsed]() {
+            return writeIndex + recordSize - buffer->readIndex.load(std::memory_order_acquire) <= limitUsed;
+        };
+        while (!hasSpace())
+        {
+            // 后端线程没有运行时无法腾出空间，任何策略下都只能丢弃
+            if (canDrop || !running_)
             {
-                assert(!buffersToWrite.empty());
-                newBuffer2 = std::move(buffersToWrite.back());
-                buffersToWrite.pop_back();
-                newBuffer2->reset();
+                buffer->droppedLines[logLevel].fetch_add(1, std::memory_order_relaxed);
+                wakeup();
+                return;
             }
+            waitForSpace(hasSpace);
+        }
 
-            buffersToWrite.clear();
-            output.flush();
+        AsyncThreadBuffer::RecordHeader header{static_cast<uint32_t>(length), type, timestamp};
+        buffer->copyIn(writeIndex, &header, sizeof(header));
+        buffer->copyIn(writeIndex + sizeof(header), data1, len1);
+        buffer->copyIn(writeIndex + sizeof(header) + len1, data2, len2);
+        buffer->writeIndex.store(writeIndex + recordSize, std::memory_order_release);
+
+        if (writeIndex + recordSize - buffer->readIndex.load(std::memory_order_relaxed) > buffer->capacity / 2)
+        {
+            wakeup();
         }
+    }
 
-        output.flush();
+    void AsyncLogging::appendLargeRecord(AsyncThreadBuffer *buffer, LogLevel logLevel, int64_t timestamp, const char *data, size_t len)
+    {
+        // 没有尚未写出的 LargeRecord 时总是接受，因此单条日志的大小不受限制
+        bool canDrop = droppable(logLevel);
+        auto hasSpace = [this, len]() {
+            size_t bytes = largeRecordBytes_.load();
+            return bytes == 0 || bytes + len <= MaxLargeRecordBytes;
+        };
+        while (!hasSpace())
+        {
+            if (canDrop || !running_)
+            {
+                buffer->droppedLines[logLevel].fetch_add(1, std::memory_order_relaxed);
+                wakeup();
+                return;
+            }
+            waitForSpace(hasSpace);
+        }
+
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            largeRecords_.push_back({timestamp, std::string(data, len)});
+            largeRecordBytes_ += len;
+        }
+        wakeup();
     }
 
-    void AsyncLogging::append(const LogContextPtr &context)
+    void AsyncLogging::harvest(std::vector<ThreadBufferPtr> &threadBuffers, std::vector<LargeRecord> &largeRecords, Buffer &buffer,
+                               FileHandler &output, LogContext &context, std::vector<char> &scratch)
     {
-        std::unique_lock<std::mutex> locker(mutex_);
-        if (currentBuffer_->remainingCapacity() > context->view().size())
+        // 放不进 buffer 的日志消息在写出 buffer 中已有的内容后直接写出
+        auto write = [&buffer, &output](std::string_view line) {
+            if (!buffer.append(line))
+            {
+                output.append(buffer.begin(), buffer.size());
+                buffer.reset();
+                if (!buffer.append(line))
+                {
+                    output.append(line.data(), static_cast<int>(line.size()));
+                }
+            }
+        };
+
+        std::stable_sort(largeRecords.begin(), largeRecords.end(),
+                         [](const LargeRecord &lhs, const LargeRecord &rhs) { return lhs.timestamp < rhs.timestamp; });
+        size_t large = 0;
+
+        struct Cursor
         {
-            currentBuffer_->append(context->view());
+            AsyncThreadBuffer *buffer;
+            uint64_t index;
+            uint64_t end;
+            int64_t timestamp;
+        };
+
+        std::vector<Cursor> cursors;
+        cursors.reserve(threadBuffers.size());
+        for (const auto &threadBuffer : threadBuffers)
+        {
+            uint64_t index = threadBuffer->readIndex.load(std::memory_order_relaxed);
+            uint64_t end = threadBuffer->writeIndex.load(std::memory_order_acquire);
+            if (index != end)
+            {
+                cursors.push_back({threadBuffer.get(), index, end, threadBuffer->header(index).timestamp});
+            }
         }
-        else
+
+        // 每次取时间戳最小的一条日志，线程数通常不多，线性查找即可
+        while (!cursors.empty() || large < largeRecords.size())
         {
-            buffers_.push_back(std::move(currentBuffer_));
+            size_t min = 0;
+            for (size_t i = 1; i < cursors.size(); ++i)
+            {
+                if (cursors[i].timestamp < cursors[min].timestamp)
+                {
+                    min = i;
+                }
+            }
 
-            if (nextBuffer_)
+            if (large < largeRecords.size() && (cursors.empty() || largeRecords[large].timestamp < cursors[min].timestamp))
             {
-                currentBuffer_ = std::move(nextBuffer_);
+                write(largeRecords[large].line);
+                largeRecordBytes_ -= largeRecords[large].line.size();
+                ++large;
+                continue;
+            }
+
+            Cursor &cursor = cursors[min];
+            AsyncThreadBuffer::RecordHeader header = cursor.buffer->header(cursor.index);
+            if (header.type == AsyncThreadBuffer::TextRecord)
+            {
+                // 环形缓冲区中的记录不超过 AsyncBufferSize / 4，一定能放进空的 buffer
+                if (static_cast<size_t>(buffer.remainingCapacity()) < header.length)
+                {
+                    output.append(buffer.begin(), buffer.size());
+                    buffer.reset();
+                }
+                cursor.buffer->copyOut(cursor.index + sizeof(header), buffer.current(), header.length);
+                buffer.add(header.length);
             }
             else
             {
-                currentBuffer_.reset(new Buffer(AsyncBufferSize));
+                // 参数可能跨越环形缓冲区的末尾，先拷贝到连续的内存中再解码
+                if (scratch.size() < header.length)
+                {
+                    scratch.resize(header.length);
+                }
+                cursor.buffer->copyOut(cursor.index + sizeof(header), scratch.data(), header.length);
+
+                const LogSite *site;
+                LogDecodeFunc decode;
+                memcpy(&site, scratch.data(), sizeof(site));
+                memcpy(&decode, scratch.data() + sizeof(site), sizeof(decode));
+
+                context.begin(site->sourceFilename, site->funcname, site->line, site->logLevel, header.timestamp,
+                              cursor.buffer->threadId, cursor.buffer->threadLogId);
+                decode(scratch.data() + sizeof(site) + sizeof(decode), context, site->format);
+                context << '\n';
+
+                write(context.view());
+                context.end();
             }
+            cursor.index += sizeof(header) + header.length;
 
-            currentBuffer_->append(context->view());
+            if (cursor.index == cursor.end)
+            {
+                cursor.buffer->readIndex.store(cursor.end, std::memory_order_release);
+                cursors.erase(cursors.begin() + static_cast<std::ptrdiff_t>(min));
+                notifyNotFull();
+            }
+            else
+            {
+                cursor.timestamp = cursor.buffer->header(cursor.index).timestamp;
+            }
+        }
 
-            // 测试使用
-            // std::cout << __LINE__ << "前端写满一块buffer" << std::endl;
+        if (!largeRecords.empty())
+        {
+            largeRecords.clear();
+            notifyNotFull();
+        }
 
-            cv_.notify_one();
+        if (buffer.size() > 0)
+        {
+            output.append(buffer.begin(), buffer.size());
+            buffer.reset();
         }
     }
 
+    void AsyncLogging::run()
+    {
+        assert(running_ == true);
+        latch_.countDown();
+        FileHandler output("AsyncLogging-FileHandler", logLevel_, logFilepath_, flushInterval_, flushEveryNLine_, fileRollSize_,
+                           true, fileType_);
+        Buffer buffer(AsyncBufferSize);
+        std::vector<ThreadBufferPtr> threadBuffers;
+        std::unique_ptr<LogContext> context(new LogContext());
+        std::vector<char> scratch;
+        std::vector<LargeRecord> largeRecords;
+        uint64_t reportedDroppedLines = 0;
+        bool running = true;
+        while (running)
+        {
+            {
+                std::unique_lock<std::mutex> locker(mutex_);
+                // flushInterval_ 时间间隔过后，即使各线程的缓冲区还没有过半，也写一次日志，以保证及时写日志。
+                cv_.wait_for(locker, std::chrono::seconds(flushInterval_),
+                             [this]() { return wakeupPending_ || !running_; });
+                wakeupPending_ = false;
+                running = running_;
+
+                if (threadBuffersChanged_)
+                {
+                    threadBuffersChanged_ = false;
+                    threadBuffers = threadBuffers_;
+                }
+
+                // 先于各线程缓冲区取出，保证同一线程中更早写入的日志也在本轮被收集
+                largeRecords.swap(largeRecords_);
+            }
+
+            harvest(threadBuffers, largeRecords, buffer, output, *context, scratch);
+
+            uint64_t dropped = droppedLines();
+            if (dropped != reportedDroppedLines)
+            {
+                context->begin(__FILE__, __FUNCTION__, __LINE__, LogLevel::WARN);
+                *context << "AsyncLogging dropped " << dropped - reportedDroppedLines << " log lines, "
+                         << dropped << " in total\n";
+                std::string_view line = context->view();
+                fwrite(line.data(), 1, line.size(), stderr);
+                output.append(line.data(), static_cast<int>(line.size()));
+                context->end();
+                reportedDroppedLines = dropped;
+            }
+            output.flush();
+
+            // 回收已退出线程的缓冲区，线程退出前写入的日志已在上面的 harvest 中写出
+            bool removed = false;
+            for (const auto &threadBuffer : threadBuffers)
+            {
+                if (!threadBuffer->producerAlive &&
+                    threadBuffer->readIndex.load(std::memory_order_relaxed) == threadBuffer->writeIndex.load(std::memory_order_acquire))
+                {
+                    removed = true;
+                }
+            }
+            if (removed)
+            {
+                std::unique_lock<std::mutex> locker(mutex_);
+                auto isDead = [](const ThreadBufferPtr &threadBuffer) {
+                    return !threadBuffer->producerAlive &&
+                           threadBuffer->readIndex.load(std::memory_order_relaxed) == threadBuffer->writeIndex.load(std::memory_order_acquire);
+                };
+                for (const auto &threadBuffer : threadBuffers_)
+                {
+                    if (isDead(threadBuffer))
+                    {
+                        for (int level = 0; level < LogLevel::NUM_LOG_LEVELS; ++level)
+                        {
+                            retiredDroppedLines_[level] += threadBuffer->droppedLines[level].load(std::memory_order_relaxed);
+                        }
+                    }
+                }
+                threadBuffers_.erase(std::remove_if(threadBuffers_.begin(), threadBuffers_.end(), isDead), threadBuffers_.end());
+                threadBuffers = threadBuffers_;
+            }
+        }
+
+        output.flush();
+    }
+
 } // namespace cpp_example
@@ -2,6 +2,7 @@
 #define STNL_LOGGER_H
 
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <string>
 #include <iostream>
 #include <string_view>
@@ -11,6 +12,7 @@
 #include <mutex>
 #include <vector>
 #include <atomic>
+#include <cstring>
 #include <condition_variable>
 
 #include "noncopyable.h"
@@ -25,11 +27,18 @@ namespace stnl
     class LogRecorder; 
     class LogHandler;   
     class AsyncLogging;
-
-    using LogContextPtr = std::shared_ptr<LogContext>;
+    struct AsyncThreadBuffer;
 
     const int LogFileBufferSize = 1024 * 16;
 
+/**
+ * 编译期的最低日志级别，低于该级别的日志语句在编译期即被消除，例如：
+ * add_compile_definitions(STNL_LOG_MIN_LEVEL=2) 去掉所有的 LOG_TRACE 和 LOG_DEBUG
+ */
+#ifndef STNL_LOG_MIN_LEVEL
+#define STNL_LOG_MIN_LEVEL 0
+#endif
+
     enum LogLevel
     {
         TRACE = 0,
@@ -41,6 +50,24 @@ namespace stnl
         NUM_LOG_LEVELS,
     };
 
+    /**
+     * @brief 一条二进制日志语句的静态信息，每个 LOG_BINARY 调用点一个静态实例，
+     * 其地址即为该调用点的 id。见 BinaryLogging.h
+     */
+    struct LogSite
+    {
+        const char* sourceFilename;
+        const char* funcname;
+        int line;
+        LogLevel logLevel;
+        const char* format;
+    };
+
+    /**
+     * @brief 由参数的原始字节还原出参数，按照 format 格式化到 context 中
+     */
+    using LogDecodeFunc = void (*)(const char* args, LogContext& context, const char* format);
+
     class Logger: public std::enable_shared_from_this<Logger>, public noncopyable
     {
     public:
@@ -59,7 +86,7 @@ namespace stnl
          * 
          * @param context 
          */
-        void write(const LogContextPtr& context);
+        void write(const LogContext& context);
 
         /**
          * @brief 添加 LogHandler
@@ -74,60 +101,229 @@ namespace stnl
 
         void setAsyncLogger(const std::shared_ptr<AsyncLogging>& asyncLogger);
 
-    
+        AsyncLogging* asyncLogger() const { return asyncLogger_.get(); }
+
+        /**
+         * @brief 运行期的最低日志级别，低于该级别的日志在 LOGGER 宏中直接跳过，不会进行任何格式化。
+         * 默认为 INFO，与默认的 ConsoleHandler 一致；addHandler、setAsyncLogger 在新的输出端级别更低时
+         * 会随之调低。单独调低某个 LogHandler 的级别后，需要同时调用 setLogLevel。
+         */
+        static LogLevel logLevel()
+        {
+            return minLogLevel_.load(std::memory_order_relaxed);
+        }
+
+        static void setLogLevel(LogLevel logLevel);
+
+        /**
+         * @brief 日志时间使用所在 EventLoop 缓存的时钟（每次 epoll_wait 返回的时间），省去每条日志的 gettimeofday。
+         * 同一轮 loop 中的日志时间相同，精度取决于回调的执行时间。不在 EventLoop 线程中的日志不受影响。默认关闭。
+         */
+        static void setUseLoopClock(bool on);
+
+        static bool useLoopClock()
+        {
+            return useLoopClock_.load(std::memory_order_relaxed);
+        }
+
     private:
         /**
          * @brief 调用注册到Logger中的LogHandler进行写日志
          * 
          * @param context 
          */
-        void handlerWrite(const LogContextPtr& context);
+        void handlerWrite(const LogContext& context);
         
 
     private:
         std::string loggerName_;
         std::map<std::string, std::shared_ptr<LogHandler>> handlers_;
         std::shared_ptr<AsyncLogging> asyncLogger_;
+
+        static std::atomic<LogLevel> minLogLevel_;
+        static std::atomic_bool useLoopClock_;
     };
 
 
-    class LogContext: public std::ostringstream
+    /**
+     * @brief 一条日志消息的格式化缓冲区。
+     * 每个线程持有一个 thread_local 的 LogContext，LogRecorder 直接在其中格式化日志消息，
+     * 整数、浮点数的转换也不经过 iostream，因此记录一条日志不需要分配内存。
+     * 只有超过 InlineBufferSize 的日志消息才会转存到 overflow_ 中。
+     */
+    class LogContext: public noncopyable
     {
     public:
-        LogContext() = default;
-        LogContext(std::string_view sourceFilename, std::string funcname, int line, LogLevel logLevel);
+        static const size_t InlineBufferSize = 4000;
+
+        LogContext();
         ~LogContext() = default;
-    
+
+        /**
+         * @brief 开始一条新的日志消息，写入 时间 级别 文件名 函数名 行号 前缀
+         */
+        void begin(const char* sourceFilename, const char* funcname, int line, LogLevel logLevel);
+
+        /**
+         * @brief 使用给定的时间戳（微秒）开始一条日志消息，用于在后端线程格式化二进制日志
+         */
+        void begin(const char* sourceFilename, const char* funcname, int line, LogLevel logLevel, int64_t timestamp);
+
+        /**
+         * @brief 使用给定的时间戳和线程标识开始一条日志消息，线程标识为写日志的线程的 CurrentThread::logId()
+         */
+        void begin(const char* sourceFilename, const char* funcname, int line, LogLevel logLevel, int64_t timestamp,
+                   int threadId, std::string_view threadLogId);
+
+        /**
+         * @brief 日志消息已交给 Logger，LogContext 可以被复用
+         */
+        void end() { inUse_ = false; }
+
+        bool inUse() const { return inUse_; }
+
+        /**
+         * @brief 当前日志的时间戳（微秒）。Logger::useLoopClock() 开启且当前线程有缓存的时钟时使用缓存的时钟
+         */
+        static int64_t now();
+
+        /**
+         * @brief 设置当前线程缓存的时钟（微秒），由 EventLoop 在每次 epoll_wait 返回后调用，0 表示没有缓存的时钟
+         */
+        static void setThreadClock(int64_t microSecondsSinceEpoch);
+
+        std::string_view view() const
+        {
+            return overflowed_ ? std::string_view(overflow_) : std::string_view(buffer_, length_);
+        }
+
+        void append(const char* data, size_t len)
+        {
+            if (!overflowed_ && length_ + len <= InlineBufferSize)
+            {
+                memcpy(buffer_ + length_, data, len);
+                length_ += len;
+            }
+            else
+            {
+                spill(data, len);
+            }
+        }
+
+        LogContext& operator<<(bool v)
+        {
+            return *this << (v ? '1' : '0');
+        }
+
+        LogContext& operator<<(char v)
+        {
+            append(&v, 1);
+            return *this;
+        }
+
+        LogContext& operator<<(short v);
+        LogContext& operator<<(unsigned short v);
+        LogContext& operator<<(int v);
+        LogContext& operator<<(unsigned int v);
+        LogContext& operator<<(long v);
+        LogContext& operator<<(unsigned long v);
+        LogContext& operator<<(long long v);
+        LogContext& operator<<(unsigned long long v);
+
+        LogContext& operator<<(float v)
+        {
+            return *this << static_cast<double>(v);
+        }
+
+        LogContext& operator<<(double v);
+
+        LogContext& operator<<(const void* p);
+
+        LogContext& operator<<(const char* str)
+        {
+            if (str)
+            {
+                append(str, strlen(str));
+            }
+            else
+            {
+                append("(null)", 6);
+            }
+            return *this;
+        }
+
+        LogContext& operator<<(std::string_view str)
+        {
+            append(str.data(), str.size());
+            return *this;
+        }
+
+        LogContext& operator<<(const std::string& str)
+        {
+            append(str.data(), str.size());
+            return *this;
+        }
+
+        /**
+         * @brief 其他提供了 std::ostream 输出运算符的类型（如 std::thread::id），
+         * 借助一个 thread_local 的 ostringstream 转换，只在首次使用时分配内存。
+         */
+        template<typename T>
+        LogContext& operator<<(const T& v)
+        {
+            std::ostringstream& os = fallbackStream();
+            os.str(std::string());
+            os << v;
+            return *this << os.view();
+        }
+
+    private:
+        template<typename T>
+        void formatInteger(T v);
+
+        void spill(const char* data, size_t len);
+
+        static std::ostringstream& fallbackStream();
+
     public:
         int threadId_;
         LogLevel logLevel_;
+        int64_t timestamp_;     /* 微秒 */
+
+    private:
+        bool inUse_;
+        bool overflowed_;
+        size_t length_;
+        std::string overflow_;
+        char buffer_[InlineBufferSize];
     };
 
 
     /**
      * @brief 记录日志消息。
-     * 完整的日志消息格式为：20231226 20:45:32 652349 INFO main.cpp funcname 20 | log message
+     * 完整的日志消息格式为：20231226 20:45:32 652349 4567/IoThread0 INFO main.cpp funcname 20 | log message
+     * 其中 4567 为线程 id，/IoThread0 为 stnl::Thread 的名称，其他线程没有这一部分。
      * 
+     * 使用当前线程的 LogContext 格式化日志消息；若当前线程的 LogContext 正在使用中
+     * （例如在输出某个对象的过程中又记录了日志），则临时分配一个新的 LogContext。
      */
-    class LogRecorder
+    class LogRecorder: public noncopyable
     {
     public:
-        LogRecorder(const std::string_view sourceFilename, std::string funcname, int line, LogLevel logLevel, Logger &logger);
+        LogRecorder(const char* sourceFilename, const char* funcname, int line, LogLevel logLevel, Logger &logger);
         
         ~LogRecorder();
 
         template<typename T>
         LogRecorder& operator<<(T&& data)
         {
-            if (!context_) {
-                return *this;
-            }
-            (*context_) << std::forward<T>(data);
+            context_ << std::forward<T>(data);
             return *this;
         }
 
     private:
-        LogContextPtr context_;
+        std::unique_ptr<LogContext> nestedContext_;
+        LogContext& context_;
         Logger& logger_;
     };
 
@@ -140,9 +336,11 @@ namespace stnl
 
         void setLogLevel(LogLevel LogLevel);
 
+        LogLevel logLevel() const;
+
         const std::string& name() const;
 
-        virtual void write(const LogContextPtr& context) = 0;
+        virtual void write(const LogContext& context) = 0;
     
     protected:
         LogLevel logLevel_;
@@ -157,12 +355,22 @@ namespace stnl
 
         ~ConsoleHandler() override = default;
 
-        void write(const LogContextPtr& context) override;
+        void write(const LogContext& context) override;
     };
 
     
     /**
-     * @brief write log to file, no thread safe
+     * 日志文件的写入方式
+     */
+    enum class LogFileType
+    {
+        Stdio,      // stdio 缓冲，每 LogFileBufferSize 字节一次 write（默认）
+        Direct,     // 小块数据先拷贝到内部缓冲区，大块数据（如 AsyncLogging 的整块 Buffer）与之合并为一次 writev
+        Mmap,       // 预分配文件，通过滑动的 mmap 窗口写入
+    };
+
+    /**
+     * @brief 日志文件的抽象基类，write log to file, no thread safe
      * 
      */
     class LogFile: public noncopyable
@@ -170,21 +378,116 @@ namespace stnl
     public:
         explicit LogFile(std::string_view filename);
 
-        ~LogFile();
+        virtual ~LogFile() = default;
 
-        void append(const LogContextPtr& context);
+        void append(const LogContext& context);
 
-        void append(const char* buf, int len);
+        virtual void append(const char* buf, int len) = 0;
 
-        void flush(); 
+        virtual void flush() = 0;
 
         off_t writtenBytes() const;
 
-    private:
+    protected:
         std::string filename_;
+        off_t writtenBytes_;
+    };
+
+
+    class StdioLogFile: public LogFile
+    {
+    public:
+        explicit StdioLogFile(std::string_view filename);
+
+        ~StdioLogFile() override;
+
+        void append(const char* buf, int len) override;
+
+        void flush() override;
+
+    private:
         FILE* fp_;
         char buffer_[LogFileBufferSize];
-        off_t writtenBytes_;
+    };
+
+
+    /**
+     * @brief 使用 writev 直接写文件，不经过 stdio。
+     * 不超过内部缓冲区剩余空间的数据先拷贝到缓冲区中；否则将缓冲区中的数据与新数据合并为一次 writev 写出，
+     * 新数据不再拷贝。AsyncLogging 后端的整块 Buffer 因此只需要一次系统调用。
+     */
+    class DirectLogFile: public LogFile
+    {
+    public:
+        static const size_t BufferSize = 64 * 1024;
+
+        explicit DirectLogFile(std::string_view filename);
+
+        ~DirectLogFile() override;
+
+        void append(const char* buf, int len) override;
+
+        void flush() override;
+
+    private:
+        /**
+         * @brief 写出 iov 中的全部数据，处理部分写入
+         */
+        void writeFully(struct iovec* iov, int iovcnt);
+
+        int fd_;                /* O_APPEND 打开，与其他写同一文件的进程或 FileHandler 不会相互覆盖 */
+        size_t length_;         /* buffer_ 中尚未写出的字节数 */
+        std::unique_ptr<char[]> buffer_;
+    };
+
+
+    /**
+     * @brief 通过 mmap 写文件。
+     * 打开时用 fallocate 将文件预分配到 fileSize，写入时将数据拷贝到一个 WindowSize 大小的 MAP_SHARED 窗口中，
+     * 窗口写满后滑动到下一段，文件不够时再按 fileSize 扩展，写入本身没有系统调用。
+     * flush() 每隔 syncInterval 秒 msync 一次已写入的数据。
+     *
+     * 数据写入窗口后即位于内核的页缓存中，进程崩溃时不会丢失，文件中有效数据之后是预分配的 0；
+     * 正常关闭时将文件截断到实际写入的长度。重新打开已有文件时，二分查找有效数据的末尾，从最后一个非 0 字节之后继续写。
+     */
+    class MappedLogFile: public LogFile
+    {
+    public:
+        static const size_t WindowSize = 4 * 1024 * 1024;
+
+        MappedLogFile(std::string_view filename, off_t fileSize, int syncInterval);
+
+        ~MappedLogFile() override;
+
+        void append(const char* buf, int len) override;
+
+        void flush() override;
+
+    private:
+        /**
+         * @brief 将窗口移动到包含 offset 的位置
+         */
+        bool remap(off_t offset);
+
+        /**
+         * @brief 保证文件长度不小于 length
+         */
+        bool reserve(off_t length);
+
+        /**
+         * @brief 文件中最后一个非 0 字节之后的偏移，假设有效数据中没有整块（4KB）的 0
+         */
+        off_t dataEnd(off_t fileLength) const;
+
+        int fd_;
+        const off_t fileSize_;      /* 预分配的大小，也是每次扩展的大小 */
+        off_t fileLength_;          /* 文件当前的长度（包括预分配的部分） */
+        off_t offset_;              /* 下一次写入的文件偏移 */
+        off_t syncedOffset_;        /* 之前的数据已经 msync */
+        char* window_;
+        off_t windowStart_;
+        const int syncInterval_;
+        time_t lastSyncTime_;
     };
 
 
@@ -192,13 +495,14 @@ namespace stnl
     {
     public:
         FileHandler(std::string_view name, LogLevel logLevel, std::string_view filepath,
-                    int flushInterval=3, int flushEveryNLine=100 * 100, int fileRollSize=1024*1024*64, bool threadSafe=true);
+                    int flushInterval=3, int flushEveryNLine=100 * 100, int fileRollSize=1024*1024*64, bool threadSafe=true,
+                    LogFileType fileType=LogFileType::Stdio);
 
         ~FileHandler() override = default;
 
-        void write(const LogContextPtr& context) override;
+        void write(const LogContext& context) override;
 
-        void append(const LogContextPtr& context);
+        void append(const LogContext& context);
 
         void append(const char* buf, int len);
 
@@ -211,8 +515,11 @@ namespace stnl
     private:
         void append();
 
+        LogFile* newLogFile(const std::string& filename) const;
+
     private:
         std::string filepath_;
+        const LogFileType fileType_;
         std::unique_ptr<LogFile> logFile_;
 
         const int flushInterval_;
@@ -231,15 +538,37 @@ namespace stnl
 
 
     const int AsyncBufferSize = 4000000;
+    const size_t AsyncThreadBufferSize = 1024 * 1024;
 
+    /**
+     * @brief 异步日志。
+     * 每个写日志的线程第一次调用 append 时注册一个自己的环形缓冲区（AsyncThreadBuffer），
+     * 之后只向自己的缓冲区写入，不需要加锁；后端线程定期（或缓冲区过半时被唤醒）收集所有线程的缓冲区，
+     * 按每条日志的时间戳归并后写入文件，因此不同线程的日志在文件中大致保持时间顺序。
+     * 缓冲区中既可以是已格式化的文本日志，也可以是 LOG_BINARY 写入的二进制日志，后者由后端线程格式化。
+     * 线程的缓冲区写满时按 OverflowPolicy 处理，日志占用的内存不超过 线程数 * threadBufferSize。
+     */
     class AsyncLogging: public noncopyable
     {
     public:
         using Buffer = FixedBuffer;
-        using BufferVector = std::vector<std::unique_ptr<Buffer>>;
-        using BufferPtr = BufferVector::value_type;
+        using ThreadBufferPtr = std::shared_ptr<AsyncThreadBuffer>;
 
-        AsyncLogging(std::string_view logFilepath, LogLevel logLevel, int fileRollSize=64 * 1024, int flushInterval=3, int flushEveryNLine=100);
+        /**
+         * 线程缓冲区写满（后端线程来不及写文件）时 append 的处理方式
+         */
+        enum class OverflowPolicy
+        {
+            Block,          // 唤醒后端线程并等待缓冲区腾出空间，不丢日志（默认）
+            DropNewest,     // 丢弃新的日志并计数
+            DropByLevel     // 缓冲区使用超过 3/4 时丢弃低于 keepLevel 的日志，keepLevel 及以上的日志写满时等待
+        };
+
+        /**
+         * @param threadBufferSize 每个线程的缓冲区大小，向上取整为 2 的幂，最小 16KB
+         */
+        AsyncLogging(std::string_view logFilepath, LogLevel logLevel, int fileRollSize=64 * 1024, int flushInterval=3, int flushEveryNLine=100,
+                     size_t threadBufferSize=AsyncThreadBufferSize);
 
         ~AsyncLogging();
 
@@ -247,28 +576,112 @@ namespace stnl
 
         void stop();
 
-        void append(const LogContextPtr& context);
+        void append(const LogContext& context);
+
+        /**
+         * @brief 写入一条二进制日志：只拷贝调用点、解码函数和参数的原始字节，由后端线程格式化
+         */
+        void appendBinary(const LogSite& site, LogDecodeFunc decode, const char* args, size_t size);
+
+        LogLevel logLevel() const { return logLevel_; }
+
+        void setOverflowPolicy(OverflowPolicy policy, LogLevel keepLevel = LogLevel::WARN);
+
+        /**
+         * @brief 后端线程写日志文件的方式，需要在 start() 之前设置
+         */
+        void setLogFileType(LogFileType fileType);
+
+        /**
+         * @brief 因缓冲区写满（或后端线程未运行）而丢弃的日志条数，后端线程也会将新增的丢弃数写入日志文件
+         */
+        uint64_t droppedLines() const;
+
+        uint64_t droppedLines(LogLevel logLevel) const;
 
     private:
         void run();
 
+        /**
+         * @brief 将一条记录写入当前线程的缓冲区，记录的内容由 data1、data2 两段拼接而成
+         */
+        void appendRecord(uint32_t type, LogLevel logLevel, int64_t timestamp, const char* data1, size_t len1, const char* data2, size_t len2);
+
+        /**
+         * @brief 超过线程缓冲区 1/4 的日志消息不经过环形缓冲区，单独拷贝一份交给后端线程，
+         * 后端线程同样按时间戳与其他日志归并，写出时不经过后端的 Buffer
+         */
+        void appendLargeRecord(AsyncThreadBuffer* buffer, LogLevel logLevel, int64_t timestamp, const char* data, size_t len);
+
+        /**
+         * @brief 按当前的 OverflowPolicy，缓冲区写满时该级别的日志是否可以丢弃
+         */
+        bool droppable(LogLevel logLevel) const;
+
+        /**
+         * @brief 当前线程在本 AsyncLogging 中的缓冲区，第一次调用时创建并注册
+         */
+        AsyncThreadBuffer* threadBuffer();
+
+        /**
+         * @brief 收集所有线程缓冲区中的日志，按时间戳归并后写入 output
+         */
+        struct LargeRecord
+        {
+            int64_t timestamp;
+            std::string line;
+        };
+
+        void harvest(std::vector<ThreadBufferPtr>& threadBuffers, std::vector<LargeRecord>& largeRecords, Buffer& buffer,
+                     FileHandler& output, LogContext& context, std::vector<char>& scratch);
+
+        void wakeup();
+
+        /**
+         * @brief Block 策略下在 notFull_ 上等待，直到 hasSpace() 成立或后端线程停止
+         */
+        void waitForSpace(const std::function<bool()>& hasSpace);
+
+        /**
+         * @brief 后端线程腾出空间后，唤醒等待中的前端线程
+         */
+        void notifyNotFull();
+
+        const uint64_t id_;             /* 区分不同的 AsyncLogging 实例，线程据此查找自己的缓冲区 */
         std::atomic_bool running_;
         std::string logFilepath_;       /* 日志文件路径 */
         const int fileRollSize_;        /* 日志文件大小 */
-        BufferPtr currentBuffer_;
-        BufferPtr nextBuffer_;
-        BufferVector buffers_;
+        const size_t threadBufferSize_;
+        std::vector<ThreadBufferPtr> threadBuffers_;    /* guarded by mutex_ */
+        bool threadBuffersChanged_;                     /* guarded by mutex_ */
+        std::atomic_bool wakeupPending_;
+        std::vector<LargeRecord> largeRecords_;         /* guarded by mutex_ */
+        std::atomic_size_t largeRecordBytes_;           /* 尚未写出的 LargeRecord 的总大小 */
+        std::atomic<OverflowPolicy> overflowPolicy_;
+        std::atomic<LogLevel> keepLevel_;
+        uint64_t retiredDroppedLines_[LogLevel::NUM_LOG_LEVELS];   /* 已回收的线程缓冲区的丢弃数，guarded by mutex_ */
         CountDownLatch latch_;
-        std::mutex mutex_;
+        mutable std::mutex mutex_;
         std::condition_variable_any cv_;
+        std::condition_variable notFull_;               /* 与 mutex_ 配合使用 */
+        std::atomic_int blockedProducers_;              /* 在 notFull_ 上等待的线程数 */
         Thread thread_;
         LogLevel logLevel_;
         const int flushInterval_;
         const int flushEveryNLine_;
+        LogFileType fileType_;
     };
 
 
-#define LOGGER(LEVEL) LogRecorder(__FILE__, __FUNCTION__, __LINE__, LEVEL, Logger::instance())
+/**
+ * 级别判断在构造 LogRecorder 之前完成，被过滤的日志语句不会求值 << 右侧的表达式。
+ * 使用 if-else 而不是单独的 if，避免宏展开后与外层的 else 错误匹配。
+ */
+#define LOGGER(LEVEL)                                                           \
+    if ((LEVEL) < STNL_LOG_MIN_LEVEL || (LEVEL) < Logger::logLevel())           \
+        ;                                                                       \
+    else                                                                        \
+        LogRecorder(__FILE__, __FUNCTION__, __LINE__, LEVEL, Logger::instance())
 #define LOG_TRACE LOGGER(LogLevel::TRACE)
 #define LOG_DEBUG LOGGER(LogLevel::DEBUG)
 #define LOG_INFO LOGGER(LogLevel::INFO)
@@ -0,0 +1,311 @@
+#include "stnl/Buffer.h"
+#include "stnl/RingBuffer.h"
+
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+using namespace stnl;
+
+void test_NetBuffer()
+{
+    NetBuffer buf;
+    assert(buf.readableBytes() == 0);
+    assert(buf.prependableBytes() == NetBuffer::ReservedPrependSize);
+
+    std::string str(200, 'x');
+    buf.append(str);
+    assert(buf.readableBytes() == str.size());
+
+    std::string res = buf.retrieveAsString(50);
+    assert(res.size() == 50);
+    assert(buf.readableBytes() == str.size() - 50);
+
+    buf.append(std::string(2000, 'y'));
+    assert(buf.readableBytes() == str.size() - 50 + 2000);
+
+    buf.retrieveAll();
+    assert(buf.readableBytes() == 0);
+    assert(buf.prependableBytes() == NetBuffer::ReservedPrependSize);
+
+    std::cout << "test_NetBuffer pass." << std::endl;
+}
+
+void test_NetBuffer_pool()
+{
+    std::shared_ptr<BufferPool> pool = std::make_shared<BufferPool>();
+    {
+        NetBuffer buf(pool);
+        assert(!buf.hasStorage());
+        assert(buf.readableBytes() == 0);
+
+        // 按需从 pool 中借用内存块
+        buf.append(std::string(100, 'a'));
+        assert(buf.hasStorage());
+        assert(buf.capacity() == BufferPool::SizeClasses[0]);
+
+        buf.append(std::string(10000, 'b'));
+        assert(buf.capacity() == BufferPool::SizeClasses[1]);
+        std::string res = buf.retrieveAsString(100);
+        assert(res == std::string(100, 'a'));
+
+        // 读空后归还内存
+        buf.retrieveAll();
+        assert(!buf.hasStorage());
+        assert(pool->cachedBytes() == BufferPool::SizeClasses[0] + BufferPool::SizeClasses[1]);
+
+        // 再次借用时复用池中的内存块
+        int32_t len = 16;
+        buf.prepend(len);
+        assert(buf.hasStorage());
+        assert(pool->cachedBytes() == BufferPool::SizeClasses[1]);
+    }
+    assert(pool->cachedBytes() == BufferPool::SizeClasses[0] + BufferPool::SizeClasses[1]);
+
+    // 两次空闲的 shrink 之后，未被使用的内存块全部被释放
+    pool->shrink();
+    pool->shrink();
+    assert(pool->cachedBytes() == 0);
+
+    std::cout << "test_NetBuffer_pool pass." << std::endl;
+}
+
+void test_NetBuffer_ensureWritable()
+{
+    NetBuffer buf;
+
+    // 先保证可写空间，再直接写入 writeIndex()，最后用 hasWritten 提交
+    std::string expected;
+    size_t lastCapacity = buf.capacity();
+    int grows = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        const size_t len = 500;
+        buf.ensureWritable(len);
+        assert(buf.writeableBytes() >= len);
+        memset(buf.writeIndex(), 'a' + i % 26, len);
+        buf.hasWritten(len);
+        expected.append(len, static_cast<char>('a' + i % 26));
+        assert(buf.readableBytes() == expected.size());
+
+        // 容量不足时至少翻倍，而不是每次只增长 len 字节
+        if (buf.capacity() != lastCapacity)
+        {
+            assert(buf.capacity() >= lastCapacity * 2);
+            lastCapacity = buf.capacity();
+            ++grows;
+        }
+    }
+    // 写入 50000 字节，从 1KB 开始翻倍增长，只需要重新分配 6 次
+    assert(grows <= 6);
+    std::string res = buf.retrieveAllAsString();
+    assert(res == expected);
+
+    // 可写空间足够时不重新分配
+    size_t capacity = buf.capacity();
+    buf.ensureWritable(buf.writeableBytes());
+    assert(buf.capacity() == capacity);
+
+    std::cout << "test_NetBuffer_ensureWritable pass." << std::endl;
+}
+
+void test_NetBuffer_readFD()
+{
+    int fds[2];
+    int ret = ::pipe(fds);
+    assert(ret == 0);
+
+    NetBuffer buf;
+    assert(buf.readSizeHint() == NetBuffer::InitialBufferSize);
+
+    // 第一次读取溢出到 extrabuf，之后 readSizeHint 增长，数据直接读入 buffer
+    std::string msg(20000, 'm');
+    for (int i = 0; i < 3; ++i)
+    {
+        ssize_t n = ::write(fds[1], msg.data(), msg.size());
+        assert(n == static_cast<ssize_t>(msg.size()));
+
+        int savedErrno = 0;
+        n = buf.readFD(fds[0], &savedErrno);
+        assert(n == static_cast<ssize_t>(msg.size()));
+        std::string res = buf.retrieveAllAsString();
+        assert(res == msg);
+        assert(buf.readSizeHint() >= msg.size());
+    }
+
+    // 读取量变小后 readSizeHint 缓慢回落
+    std::string small(100, 's');
+    for (int i = 0; i < 100; ++i)
+    {
+        ssize_t n = ::write(fds[1], small.data(), small.size());
+        assert(n == static_cast<ssize_t>(small.size()));
+
+        int savedErrno = 0;
+        n = buf.readFD(fds[0], &savedErrno);
+        assert(n == static_cast<ssize_t>(small.size()));
+        std::string res = buf.retrieveAllAsString();
+        assert(res == small);
+    }
+    assert(buf.readSizeHint() == NetBuffer::InitialBufferSize);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    std::cout << "test_NetBuffer_readFD pass." << std::endl;
+}
+
+void test_NetBuffer_readFD_pool()
+{
+    int fds[2];
+    int ret = ::pipe(fds);
+    assert(ret == 0);
+
+    std::shared_ptr<BufferPool> pool = std::make_shared<BufferPool>();
+    NetBuffer buf(pool);
+
+    // 连续增大的读取量使 readSizeHint 增长到上限
+    std::string msg;
+    for (size_t len : {40000, 50000})
+    {
+        msg.assign(len, 'm');
+        ssize_t n = ::write(fds[1], msg.data(), msg.size());
+        assert(n == static_cast<ssize_t>(msg.size()));
+
+        int savedErrno = 0;
+        n = buf.readFD(fds[0], &savedErrno);
+        assert(n == static_cast<ssize_t>(msg.size()));
+        std::string res = buf.retrieveAllAsString();
+        assert(res == msg);
+    }
+    assert(buf.readSizeHint() == NetBuffer::MaxReadSizeHint);
+
+    // 按上限预留空间的 buffer 仍然使用池中最大的内存块，读空后归还给池
+    ssize_t n = ::write(fds[1], msg.data(), msg.size());
+    assert(n == static_cast<ssize_t>(msg.size()));
+    int savedErrno = 0;
+    n = buf.readFD(fds[0], &savedErrno);
+    assert(n == static_cast<ssize_t>(msg.size()));
+    assert(buf.capacity() == BufferPool::MaxChunkSize);
+    size_t cached = pool->cachedBytes();
+    buf.retrieveAll();
+    assert(pool->cachedBytes() == cached + BufferPool::MaxChunkSize);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    std::cout << "test_NetBuffer_readFD_pool pass." << std::endl;
+}
+
+void test_RingBuffer()
+{
+    RingBuffer buf(4096);
+    size_t capacity = buf.capacity();
+    assert(buf.readableBytes() == 0);
+    assert(buf.writeableBytes() == capacity);
+
+    // 反复写入、读出，使数据跨越环形缓冲区的末尾，检查可读数据始终连续
+    std::string data;
+    for (int i = 0; i < 256; ++i)
+    {
+        data.push_back(static_cast<char>('a' + i % 26));
+    }
+    for (int round = 0; round < 100; ++round)
+    {
+        buf.append(data);
+        buf.append(data);
+        assert(std::string(buf.peek(), data.size()) == data);
+        buf.retrieve(data.size());
+        std::string res = buf.retrieveAsString(data.size());
+        assert(res == data);
+    }
+    assert(buf.capacity() == capacity);
+
+    // prepend 不受 8 字节的限制
+    buf.append(data);
+    std::string header(100, 'h');
+    buf.prepend(header.data(), header.size());
+    std::string res = buf.retrieveAsString(header.size());
+    assert(res == header);
+    res = buf.retrieveAllAsString();
+    assert(res == data);
+
+    // 超出容量后扩容，数据保持不变
+    std::string big(capacity * 3, 'z');
+    buf.append(data);
+    buf.append(big);
+    assert(buf.capacity() >= data.size() + big.size());
+    res = buf.retrieveAsString(data.size());
+    assert(res == data);
+    res = buf.retrieveAllAsString();
+    assert(res == big);
+
+    std::cout << "test_RingBuffer pass." << std::endl;
+}
+
+void test_RingBuffer_readFD()
+{
+    int fds[2];
+    int ret = ::pipe(fds);
+    assert(ret == 0);
+
+    RingBuffer buf(4096);
+    std::string data(3000, 'r');
+    buf.append(data);
+    buf.retrieve(2000);
+
+    // 写入的数据会跨越缓冲区末尾，并溢出到 extrabuf
+    std::string msg(6000, 'p');
+    ssize_t n = ::write(fds[1], msg.data(), msg.size());
+    assert(n == static_cast<ssize_t>(msg.size()));
+
+    int savedErrno = 0;
+    n = buf.readFD(fds[0], &savedErrno);
+    assert(n == static_cast<ssize_t>(msg.size()));
+    std::string res = buf.retrieveAsString(1000);
+    assert(res == std::string(1000, 'r'));
+    res = buf.retrieveAllAsString();
+    assert(res == msg);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    std::cout << "test_RingBuffer_readFD pass." << std::endl;
+}
+
+void test_FixedBuffer()
+{
+    FixedBuffer buf(16);
+    bool appended = buf.append("0123456789", 10);
+    assert(appended);
+    assert(buf.size() == 10);
+
+    // 放不下时不写入任何数据
+    appended = buf.append("0123456789", 10);
+    assert(!appended);
+    assert(buf.size() == 10);
+
+    // 恰好写满
+    appended = buf.append(std::string_view("abcdef"));
+    assert(appended);
+    assert(buf.remainingCapacity() == 0);
+    assert(std::string_view(buf.begin(), buf.size()) == "0123456789abcdef");
+
+    buf.clear();
+    assert(buf.size() == 0);
+    appended = buf.append("x", 1);
+    assert(appended);
+
+    std::cout << "test_FixedBuffer pass." << std::endl;
+}
+
+int main()
+{
+    test_NetBuffer();
+    test_NetBuffer_pool();
+    test_NetBuffer_ensureWritable();
+    test_NetBuffer_readFD();
+    test_NetBuffer_readFD_pool();
+    test_RingBuffer();
+    test_RingBuffer_readFD();
+    test_FixedBuffer();
+}
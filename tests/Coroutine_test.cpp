@@ -0,0 +1,214 @@
+#include "stnl/Coroutine.h"
+#include "stnl/TcpServer.h"
+#include "stnl/TcpClient.h"
+#include "stnl/TimeUtil.h"
+#include "stnl/Timer.h"
+#include "stnl/logger.h"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace stnl;
+using namespace std::placeholders;
+
+const uint16_t g_port = 38808;
+
+/* 回显服务：先读 4 字节的十进制长度，再读对应长度的消息，原样写回 */
+Task<> echoSession(TcpConnection::TcpConnectionPtr conn)
+{
+    while (true)
+    {
+        std::string header = co_await conn->read(4);
+        if (header.size() < 4)
+        {
+            break;
+        }
+        std::string body = co_await conn->read(std::stoul(header));
+        bool ok = co_await conn->write(header + body);
+        if (!ok)
+        {
+            break;
+        }
+    }
+    std::cout << "echoSession finish." << std::endl;
+}
+
+void onServerConnection(const TcpConnection::TcpConnectionPtr &conn)
+{
+    if (conn->isConnected())
+    {
+        echoSession(conn).detach();
+    }
+}
+
+void serverThread()
+{
+    TcpServer server(SockAddr("127.0.0.1", g_port), "Coroutine-Server");
+    server.setConnectionCallback(onServerConnection);
+    server.start();
+}
+
+Task<std::string> request(TcpConnection::TcpConnectionPtr conn, std::string msg)
+{
+    char header[8];
+    snprintf(header, sizeof(header), "%04zu", msg.size());
+    co_await conn->write(header + msg);
+    std::string reply = co_await conn->read(4 + msg.size());
+    co_return reply.substr(4);
+}
+
+Task<> client(EventLoop *loop, TcpClient *tcpClient)
+{
+    TcpConnection::TcpConnectionPtr conn = co_await tcpClient->asyncConnect();
+    assert(conn && conn->isConnected());
+
+    Timestamp before = Timestamp::now();
+    co_await loop->sleep(0.1);
+    assert(Timestamp::now().milliSecondsSinceEpoch() - before.milliSecondsSinceEpoch() >= 100);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        std::string msg(i * 10, static_cast<char>('a' + i % 26));
+        std::string reply = co_await request(conn, msg);
+        assert(reply == msg);
+    }
+
+    // 稳态下协程帧从 FrameAllocator 中复用，不再从堆上分配
+    size_t heapAllocations = FrameAllocator::heapAllocations();
+    for (int i = 0; i < 100; ++i)
+    {
+        std::string reply = co_await request(conn, "steady");
+        assert(reply == "steady");
+    }
+    assert(FrameAllocator::heapAllocations() == heapAllocations);
+
+    std::cout << "client pass." << std::endl;
+    loop->quit();
+}
+
+/* 协程帧销毁时析构，用来确认协程帧已被释放 */
+struct FrameReleased
+{
+    bool *released;
+
+    ~FrameReleased() { *released = true; }
+};
+
+Task<> waitConnect(TcpClient *tcpClient, bool *resumed, bool *released)
+{
+    FrameReleased guard{released};
+    TcpConnection::TcpConnectionPtr conn = co_await tcpClient->asyncConnect();
+    assert(!conn);
+    *resumed = true;
+}
+
+/* 在其他线程中调用 stop()：唤醒等待连接的协程；stop() 之后立即析构 TcpClient 时，
+   析构函数以空连接恢复等待的协程，排队的唤醒不再访问 TcpClient */
+void test_stopFromOtherThread()
+{
+    EventLoop loop;
+    // 没有服务端监听的端口，连接一直失败重试
+    SockAddr addr("127.0.0.1", g_port + 1);
+    bool resumed = false;
+    bool released = false;
+    TcpClient tcpClient(&loop, addr, "Stop-Client");
+    waitConnect(&tcpClient, &resumed, &released).detach();
+
+    bool destroyedResumed = false;
+    bool destroyedReleased = false;
+    std::unique_ptr<TcpClient> destroyed(new TcpClient(&loop, addr, "Destroyed-Client"));
+    waitConnect(destroyed.get(), &destroyedResumed, &destroyedReleased).detach();
+
+    loop.runAfter(0.1, [&]() {
+        std::thread([&]() {
+            tcpClient.stop();
+            destroyed->stop();
+        }).join();
+        destroyed.reset();
+    });
+    loop.runAfter(0.3, [&]() { loop.quit(); });
+    loop.loop();
+
+    assert(resumed && released);
+    assert(destroyedResumed && destroyedReleased);
+    std::cout << "test_stopFromOtherThread pass." << std::endl;
+}
+
+/* TcpClient 在协程等待连接时析构：协程以空连接恢复，执行完毕后释放协程帧 */
+void test_destroyWhileConnecting()
+{
+    EventLoop loop;
+    SockAddr addr("127.0.0.1", g_port + 1);
+    bool resumed = false;
+    bool released = false;
+    std::unique_ptr<TcpClient> tcpClient(new TcpClient(&loop, addr, "Destroy-Client"));
+    waitConnect(tcpClient.get(), &resumed, &released).detach();
+
+    loop.runAfter(0.1, [&]() { tcpClient.reset(); });
+    loop.runAfter(0.2, [&]() { loop.quit(); });
+    loop.loop();
+
+    assert(resumed && released);
+    std::cout << "test_destroyWhileConnecting pass." << std::endl;
+}
+
+Task<int> failing()
+{
+    throw std::runtime_error("coroutine failed");
+    co_return 0;
+}
+
+Task<> awaitFailing(bool *caught)
+{
+    try
+    {
+        co_await failing();
+    }
+    catch (const std::runtime_error &)
+    {
+        *caught = true;
+    }
+}
+
+/* 被 co_await 的协程的异常交给等待者；detach 的协程抛出异常时终止进程，不抛进恢复它的代码中 */
+void test_exception()
+{
+    bool caught = false;
+    awaitFailing(&caught).detach();
+    assert(caught);
+
+    pid_t pid = ::fork();
+    assert(pid >= 0);
+    if (pid == 0)
+    {
+        failing().detach();
+        ::_exit(0);
+    }
+    int status = 0;
+    pid_t waited = ::waitpid(pid, &status, 0);
+    assert(waited == pid);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+
+    std::cout << "test_exception pass." << std::endl;
+}
+
+int main()
+{
+    test_exception();
+    std::thread(test_stopFromOtherThread).join();
+    std::thread(test_destroyWhileConnecting).join();
+
+    std::thread t(serverThread);
+    t.detach();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    EventLoop loop;
+    TcpClient tcpClient(&loop, SockAddr("127.0.0.1", g_port), "Coroutine-Client");
+    client(&loop, &tcpClient).detach();
+    loop.loop();
+}
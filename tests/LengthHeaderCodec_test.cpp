@@ -0,0 +1,113 @@
+#include "stnl/LengthHeaderCodec.h"
+#include "stnl/logger.h"
+#include "stnl/TimeUtil.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace stnl;
+using namespace std::placeholders;
+
+std::vector<std::string> g_messages;
+
+void onStringMessage(const TcpConnection::TcpConnectionPtr &, std::string_view message, Timestamp)
+{
+    g_messages.emplace_back(message);
+}
+
+void test_codec(int headerLength)
+{
+    g_messages.clear();
+    LengthHeaderCodec codec(onStringMessage, headerLength);
+
+    // 编码三条消息到同一个 buffer 中
+    std::vector<std::string> messages = {"hello", "", std::string(3000, 'x')};
+    NetBuffer stream;
+    for (const auto &msg : messages)
+    {
+        NetBuffer frame;
+        frame.append(msg);
+        bool ok = codec.encode(&frame);
+        assert(ok);
+        assert(frame.readableBytes() == msg.size() + headerLength);
+        stream.append(frame.peek(), frame.readableBytes());
+    }
+
+    // 逐字节到达的半包数据不会产生消息
+    NetBuffer input;
+    input.append(stream.peek(), headerLength - 1);
+    codec.onMessage(nullptr, &input, Timestamp::now());
+    assert(g_messages.empty());
+    assert(input.readableBytes() == static_cast<size_t>(headerLength - 1));
+
+    // 剩余数据一次到达，一次回调中解析出全部完整的消息
+    input.append(stream.peek() + headerLength - 1, stream.readableBytes() - headerLength + 1 - 10);
+    codec.onMessage(nullptr, &input, Timestamp::now());
+    assert(g_messages.size() == 2);
+    assert(g_messages[0] == messages[0]);
+    assert(g_messages[1] == messages[1]);
+
+    input.append(stream.peek() + stream.readableBytes() - 10, 10);
+    codec.onMessage(nullptr, &input, Timestamp::now());
+    assert(g_messages.size() == 3);
+    assert(g_messages[2] == messages[2]);
+    assert(input.readableBytes() == 0);
+
+    std::cout << "test_codec(" << headerLength << ") pass." << std::endl;
+}
+
+void test_invalid_length()
+{
+    g_messages.clear();
+    LengthHeaderCodec codec(onStringMessage, 4, 1024);
+
+    NetBuffer frame;
+    frame.append(std::string(2048, 'x'));
+    bool ok = LengthHeaderCodec(onStringMessage, 4).encode(&frame);
+    assert(ok);
+
+    codec.onMessage(nullptr, &frame, Timestamp::now());
+    assert(g_messages.empty());
+    assert(frame.readableBytes() == 0);
+
+    std::cout << "test_invalid_length pass." << std::endl;
+}
+
+void test_encode_too_long()
+{
+    // 2 字节长度头无法表示超过 65535 字节的消息，拒绝编码而不是写出被截断的长度
+    LengthHeaderCodec codec(onStringMessage, 2);
+    std::string msg(UINT16_MAX + 1, 'x');
+    NetBuffer frame;
+    frame.append(msg);
+    bool ok = codec.encode(&frame);
+    assert(!ok);
+    assert(frame.readableBytes() == msg.size());
+    assert(frame.prependableBytes() == NetBuffer::ReservedPrependSize);
+
+    // 超过构造时指定的最大长度同样拒绝
+    LengthHeaderCodec limited(onStringMessage, 4, 1024);
+    NetBuffer large;
+    large.append(std::string(1025, 'y'));
+    ok = limited.encode(&large);
+    assert(!ok);
+    assert(large.readableBytes() == 1025);
+
+    // 恰好等于最大长度的消息可以正常编码
+    frame.retrieve(1);
+    ok = codec.encode(&frame);
+    assert(ok);
+    assert(frame.readableBytes() == UINT16_MAX + 2);
+
+    std::cout << "test_encode_too_long pass." << std::endl;
+}
+
+int main()
+{
+    test_codec(2);
+    test_codec(4);
+    test_codec(8);
+    test_invalid_length();
+    test_encode_too_long();
+}
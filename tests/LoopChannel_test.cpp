@@ -0,0 +1,87 @@
+#include "stnl/SpscQueue.h"
+#include "stnl/EventLoop.h"
+#include "stnl/EventLoopThread.h"
+
+#include <iostream>
+#include <thread>
+#include <memory>
+#include <cassert>
+
+using namespace stnl;
+
+void test_spsc_queue()
+{
+    SpscQueue<std::unique_ptr<int>, 4> queue;
+    const int count = 100000;
+
+    std::thread producer([&]() {
+        for (int i = 0; i < count; ++i)
+        {
+            queue.push(std::make_unique<int>(i));
+        }
+    });
+
+    int expected = 0;
+    while (expected < count)
+    {
+        queue.consume([&](std::unique_ptr<int> &value) {
+            assert(*value == expected);
+            ++expected;
+        }, 16);
+    }
+    producer.join();
+    assert(queue.empty());
+
+    std::cout << "test_spsc_queue pass." << std::endl;
+}
+
+void test_cross_loop()
+{
+    EventLoop consumer;
+    const int producerNums = 3;
+    const int count = 20000;
+
+    int next[producerNums] = {0};
+    int finished = 0;
+
+    std::vector<std::unique_ptr<EventLoopThread>> threads;
+    for (int p = 0; p < producerNums; ++p)
+    {
+        threads.emplace_back(new EventLoopThread("producer"));
+        EventLoop *producer = threads.back()->startLoop();
+
+        // 在生产者 loop 线程中向 consumer 发送任务，经过两个 loop 之间的通道
+        producer->runInLoop([&, p]() {
+            for (int i = 0; i < count; ++i)
+            {
+                consumer.queueInLoop([&, p, i]() {
+                    consumer.assertInLoopThread();
+                    // 同一个生产者的任务保持 FIFO 顺序
+                    assert(next[p] == i);
+                    ++next[p];
+                    if (i == count - 1 && ++finished == producerNums)
+                    {
+                        consumer.quit();
+                    }
+                });
+            }
+        });
+    }
+
+    consumer.loop();
+    for (int p = 0; p < producerNums; ++p)
+    {
+        assert(next[p] == count);
+    }
+
+    // 生产者 loop 析构后，通道中剩余的任务仍然会被执行
+    threads.clear();
+
+    std::cout << "test_cross_loop pass." << std::endl;
+}
+
+int main()
+{
+    test_spsc_queue();
+    test_cross_loop();
+}
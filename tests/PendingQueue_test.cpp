@@ -0,0 +1,258 @@
+#include "stnl/EventLoop.h"
+#include "stnl/EventLoopThread.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cassert>
+#include <thread>
+#include <atomic>
+
+using namespace stnl;
+
+/**
+ * 执行 loop 中已经投递的任务后退出
+ */
+void drain(EventLoop &loop)
+{
+    loop.queueInLoop([&loop]() { loop.quit(); });
+    loop.loop();
+}
+
+void test_reject()
+{
+    EventLoop loop;
+    loop.setPendingQueueCapacity(3, EventLoop::OverflowPolicy::Reject);
+
+    int executed = 0;
+    int queued = 0;
+    for (int i = 0; i < 5; ++i)
+    {
+        if (loop.tryQueueInLoop([&]() { ++executed; }) == EventLoop::QueueStatus::Queued)
+        {
+            ++queued;
+        }
+    }
+    assert(queued == 3);
+    assert(loop.rejectedFunctionCount() == 2);
+    assert(loop.pendingFunctionCount() == 3);
+
+    // queueInLoop 投递的任务不受容量限制
+    loop.queueInLoop([&]() { ++executed; });
+    assert(loop.pendingFunctionCount() == 4);
+
+    drain(loop);
+    assert(executed == 4);
+    assert(loop.pendingFunctionCount() == 0);
+
+    std::cout << "test_reject pass." << std::endl;
+}
+
+void test_drop_oldest()
+{
+    EventLoop loop;
+    loop.setPendingQueueCapacity(3, EventLoop::OverflowPolicy::DropOldest);
+
+    std::vector<int> executed;
+    bool control = false;
+    loop.queueInLoop([&]() { control = true; });
+    for (int i = 0; i < 5; ++i)
+    {
+        EventLoop::QueueStatus status = loop.tryQueueInLoop([&, i]() { executed.push_back(i); });
+        assert(status == EventLoop::QueueStatus::Queued);
+    }
+
+    // 共 7 个任务，超出容量 4 个：丢弃最早的 4 个可丢弃任务，queueInLoop 的任务保留
+    loop.queueInLoop([&loop]() { loop.quit(); });
+    loop.loop();
+    assert(control);
+    assert(executed.size() == 1 && executed[0] == 4);
+    assert(loop.droppedFunctionCount() == 4);
+
+    std::cout << "test_drop_oldest pass." << std::endl;
+}
+
+void test_drop_oldest_stalled()
+{
+    EventLoopThread loopThread("drop-oldest");
+    EventLoop *loop = loopThread.startLoop();
+    const size_t capacity = 8;
+    loop->setPendingQueueCapacity(capacity, EventLoop::OverflowPolicy::DropOldest);
+
+    // loop 阻塞在一个任务中
+    std::atomic_bool stalled(false);
+    std::atomic_bool release(false);
+    loop->queueInLoop([&]() {
+        stalled = true;
+        while (!release)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    while (!stalled)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // loop 阻塞期间在入队时丢弃最早的任务，持有的任务数不超过容量
+    std::vector<int> executed;
+    const int tasks = 10 * capacity;
+    for (int i = 0; i < tasks; ++i)
+    {
+        EventLoop::QueueStatus status = loop->tryQueueInLoop([&executed, i]() { executed.push_back(i); });
+        assert(status == EventLoop::QueueStatus::Queued);
+        assert(loop->pendingFunctionCount() <= capacity);
+    }
+    // 阻塞中的任务占用一个名额，只保留最新的 capacity - 1 个任务
+    assert(loop->droppedFunctionCount() == tasks - (capacity - 1));
+
+    std::atomic_bool done(false);
+    release = true;
+    loop->queueInLoop([&done]() { done = true; });
+    while (!done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(executed.size() == capacity - 1);
+    for (size_t i = 0; i < executed.size(); ++i)
+    {
+        assert(executed[i] == static_cast<int>(tasks - (capacity - 1) + i));
+    }
+    assert(loop->droppedFunctionCount() == tasks - (capacity - 1));
+
+    std::cout << "test_drop_oldest_stalled pass." << std::endl;
+}
+
+void test_block()
+{
+    EventLoopThread loopThread("block");
+    EventLoop *loop = loopThread.startLoop();
+    loop->setPendingQueueCapacity(2, EventLoop::OverflowPolicy::Block);
+
+    std::atomic_int executed(0);
+    std::atomic_size_t maxPending(0);
+    loop->queueInLoop([]() { std::this_thread::sleep_for(std::chrono::milliseconds(100)); });
+    for (int i = 0; i < 100; ++i)
+    {
+        EventLoop::QueueStatus status = loop->tryQueueInLoop([&]() { ++executed; });
+        assert(status == EventLoop::QueueStatus::Queued);
+        maxPending = std::max<size_t>(maxPending, loop->pendingFunctionCount());
+    }
+
+    while (executed != 100)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // 生产者被阻塞，队列长度不会无限增长
+    assert(maxPending <= 3);
+    assert(loop->rejectedFunctionCount() == 0);
+
+    std::cout << "test_block pass." << std::endl;
+}
+
+void test_block_producers()
+{
+    EventLoopThread loopThread("block-producers");
+    EventLoop *loop = loopThread.startLoop();
+    const size_t capacity = 4;
+    loop->setPendingQueueCapacity(capacity, EventLoop::OverflowPolicy::Block);
+
+    // 多个生产者同时等待，被唤醒后也不能超过容量
+    const int producers = 8;
+    const int tasksPerProducer = 500;
+    std::atomic_int executed(0);
+    std::atomic_size_t maxPending(0);
+    auto updateMax = [&maxPending](size_t pending) {
+        size_t current = maxPending;
+        while (pending > current && !maxPending.compare_exchange_weak(current, pending))
+        {
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < producers; ++i)
+    {
+        threads.emplace_back([&]() {
+            for (int n = 0; n < tasksPerProducer; ++n)
+            {
+                EventLoop::QueueStatus status = loop->tryQueueInLoop([&]() {
+                    updateMax(loop->pendingFunctionCount());
+                    if (executed++ % 100 == 0)
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                });
+                assert(status == EventLoop::QueueStatus::Queued);
+                updateMax(loop->pendingFunctionCount());
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    while (executed != producers * tasksPerProducer)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(maxPending <= capacity);
+    assert(loop->pendingFunctionCount() == 0);
+
+    std::cout << "test_block_producers pass." << std::endl;
+}
+
+void test_priority()
+{
+    EventLoop loop;
+    std::string order;
+    loop.queueInLoop([&]() { order += "b"; }, EventLoop::Priority::Background);
+    loop.queueInLoop([&]() { order += "i"; });
+    loop.queueInLoop([&]() { order += "c"; }, EventLoop::Priority::Control);
+    loop.queueInLoop([&]() { order += "i"; }, EventLoop::Priority::IoCritical);
+    drain(loop);
+    assert(order == "ciib");
+
+    std::cout << "test_priority pass." << std::endl;
+}
+
+void test_time_budget()
+{
+    EventLoop loop;
+    loop.setPendingTimeBudget(0.01);
+
+    std::string order;
+    for (int i = 0; i < 5; ++i)
+    {
+        loop.queueInLoop([&, i]() {
+            if (i == 0)
+            {
+                // 下一轮才会取出的 IO 任务
+                loop.queueInLoop([&]() { order += "i"; });
+            }
+            order += std::to_string(i);
+            std::this_thread::sleep_for(std::chrono::milliseconds(6));
+            if (i == 4)
+            {
+                loop.quit();
+            }
+        }, EventLoop::Priority::Background);
+    }
+    loop.loop();
+
+    // 第一轮 Background 任务用完 10ms 的预算后推迟，IO 任务不必等待所有 Background 任务执行完
+    assert(order == "01i234");
+
+    std::cout << "test_time_budget pass." << std::endl;
+}
+
+int main()
+{
+    test_reject();
+    test_drop_oldest();
+    test_drop_oldest_stalled();
+    test_block();
+    test_block_producers();
+    test_priority();
+    test_time_budget();
+}
@@ -3,6 +3,14 @@
 #include "stnl/TimeUtil.h"
 #include <memory>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
 
 
 using namespace std::placeholders;
@@ -42,13 +50,109 @@ private:
 };
 
 
+struct AcceptedConnection
+{
+    std::string name;
+    std::string peerIp;
+    uint16_t peerPort;
+};
+
+std::mutex g_mutex;
+std::vector<AcceptedConnection> g_accepted;
+
+size_t acceptedCount()
+{
+    std::unique_lock<std::mutex> locker(g_mutex);
+    return g_accepted.size();
+}
+
+/**
+ * 以 127.0.0.1:localPort 为源地址建立连接，等待服务端记录后以 RST 关闭（不进入 TIME_WAIT），源端口可以立即复用
+ */
+void connectAndReset(uint16_t serverPort, uint16_t localPort)
+{
+    size_t accepted = acceptedCount();
+
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    assert(fd >= 0);
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    local.sin_port = htons(localPort);
+    int ret = ::bind(fd, reinterpret_cast<struct sockaddr *>(&local), sizeof(local));
+    assert(ret == 0);
+
+    struct sockaddr_in server = {};
+    server.sin_family = AF_INET;
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server.sin_port = htons(serverPort);
+    ret = ::connect(fd, reinterpret_cast<struct sockaddr *>(&server), sizeof(server));
+    assert(ret == 0);
+
+    while (acceptedCount() == accepted)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    struct linger lingerOpt = {1, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lingerOpt, sizeof(lingerOpt));
+    ::close(fd);
+}
+
+/**
+ * 1. ipv4 对端的地址被正确地保存在 TcpConnection 中；
+ * 2. 同一个对端地址（ip:port）先后建立的两个连接名称不同，不会在 connections_ 中互相覆盖。
+ */
+void test_connectionNames()
+{
+    const uint16_t serverPort = 38818;
+    const uint16_t clientPort = 38819;
+
+    std::thread([serverPort]() {
+        TcpServer server(SockAddr("127.0.0.1", serverPort), "Name-Server");
+        server.setConnectionCallback([](const TcpConnection::TcpConnectionPtr& conn) {
+            if (conn->isConnected())
+            {
+                std::unique_lock<std::mutex> locker(g_mutex);
+                g_accepted.push_back({conn->name(), conn->getPeerAddr().ip_str(), conn->getPeerAddr().port()});
+            }
+        });
+        server.start();
+    }).detach();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    connectAndReset(serverPort, clientPort);
+    connectAndReset(serverPort, clientPort);
+
+    std::unique_lock<std::mutex> locker(g_mutex);
+    assert(g_accepted.size() == 2);
+    for (const auto& accepted : g_accepted)
+    {
+        assert(accepted.peerIp == "127.0.0.1");
+        assert(accepted.peerPort == clientPort);
+    }
+    assert(g_accepted[0].name != g_accepted[1].name);
+
+    std::cout << "test_connectionNames pass." << std::endl;
+}
+
 /**
  * usage: 
+ * ./TcpServer_test                 运行自动化测试
  * ./TcpServer_test 127.0.0.1 8808
  * telnet 127.0.0.1 8808
 */
 int main(int argc, char* argv[])
 {
+    if (argc < 3)
+    {
+        test_connectionNames();
+        return 0;
+    }
+
     SockAddr listenSockAddr(argv[1], atoi(argv[2]));
     EchoServer server(listenSockAddr);
     server.start();
@@ -0,0 +1,106 @@
+#include "stnl/ThreadPool.h"
+#include "stnl/EventLoop.h"
+#include "stnl/logger.h"
+
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+
+using namespace stnl;
+
+void test_submit()
+{
+    ThreadPool pool("test-pool", 4);
+    pool.start();
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; ++i)
+    {
+        futures.emplace_back(pool.submit([i]() { return i * 2; }));
+    }
+    for (int i = 0; i < 1000; ++i)
+    {
+        assert(futures[i].get() == i * 2);
+    }
+
+    // 任务中再提交任务，放入工作线程自己的队列，由其他空闲的工作线程窃取
+    std::atomic_int count(0);
+    std::future<void> parent = pool.submit([&]() {
+        for (int i = 0; i < 1000; ++i)
+        {
+            pool.post([&]() { ++count; });
+        }
+    });
+    parent.get();
+
+    pool.stop();
+    assert(count == 1000);
+
+    std::cout << "test_submit pass." << std::endl;
+}
+
+void test_submit_to_loop()
+{
+    EventLoop loop;
+    ThreadPool pool("test-pool", 2);
+    pool.start();
+
+    int results = 0;
+    for (int i = 1; i <= 100; ++i)
+    {
+        pool.submit(
+            &loop,
+            [i]() {
+                std::vector<int> v(i);
+                std::iota(v.begin(), v.end(), 1);
+                return std::accumulate(v.begin(), v.end(), 0);
+            },
+            [&, i](int sum) {
+                // 结果回到 loop 线程中处理
+                loop.assertInLoopThread();
+                assert(sum == i * (i + 1) / 2);
+                if (++results == 100)
+                {
+                    loop.quit();
+                }
+            });
+    }
+
+    loop.loop();
+    assert(results == 100);
+
+    std::cout << "test_submit_to_loop pass." << std::endl;
+}
+
+void test_task_exception()
+{
+    ThreadPool pool("exception-pool", 2);
+    pool.start();
+
+    // post 的任务抛出异常后，工作线程继续执行后面的任务
+    std::atomic_int count(0);
+    for (int i = 0; i < 100; ++i)
+    {
+        pool.post([&count, i]() {
+            ++count;
+            if (i % 10 == 0)
+            {
+                throw std::runtime_error("task failed");
+            }
+        });
+    }
+    std::future<int> future = pool.submit([]() { return 42; });
+    assert(future.get() == 42);
+
+    pool.stop();
+    assert(count == 100);
+
+    std::cout << "test_task_exception pass." << std::endl;
+}
+
+int main()
+{
+    test_submit();
+    test_task_exception();
+    test_submit_to_loop();
+}
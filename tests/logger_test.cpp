@@ -1,5 +1,15 @@
 #include <thread>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <assert.h>
+#include <unistd.h>
 #include "stnl/logger.h"
+#include "stnl/BinaryLogging.h"
 
 using namespace stnl;
 
@@ -83,7 +93,615 @@ void test_AsyncLogging()
     
 }
 
+void test_LogContext()
+{
+    LogContext context;
+    context.begin(__FILE__, __FUNCTION__, __LINE__, LogLevel::INFO);
+    size_t prefixSize = context.view().size();
+    assert(context.view().find(" INFO logger_test.cpp test_LogContext ") != std::string_view::npos);
+
+    context << 0 << ' ' << -123 << ' ' << LLONG_MIN << ' ' << ULLONG_MAX << ' '
+            << static_cast<short>(-7) << ' ' << 1.5 << ' ' << 0.1 << ' ' << 1e20 << ' '
+            << reinterpret_cast<const void *>(0x1f) << ' ' << true << ' '
+            << std::string("str") << ' ' << std::string_view("view");
+    assert(context.view().substr(prefixSize) ==
+           "0 -123 -9223372036854775808 18446744073709551615 -7 1.5 0.1 1e+20 0x1f 1 str view");
+    context.end();
+    assert(!context.inUse());
+
+    // 超过内联缓冲区大小的日志消息
+    context.begin(__FILE__, __FUNCTION__, __LINE__, LogLevel::INFO);
+    prefixSize = context.view().size();
+    std::string large(LogContext::InlineBufferSize * 2, 'x');
+    context << large << 42;
+    assert(context.view().size() == prefixSize + large.size() + 2);
+    assert(context.view().substr(context.view().size() - 2) == "42");
+    context.end();
+
+    // 复用后回到内联缓冲区
+    context.begin(__FILE__, __FUNCTION__, __LINE__, LogLevel::WARN);
+    context << "short";
+    assert(context.view().size() < LogContext::InlineBufferSize);
+    assert(context.view().substr(context.view().size() - 5) == "short");
+    context.end();
+
+    std::cout << "test_LogContext pass." << std::endl;
+}
+
+void test_LogTime()
+{
+    // 时间之后为线程标识
+    auto startsWith = [](const LogContext &context, const char *time) {
+        std::string expected = std::string(time) + " " + std::string(CurrentThread::logId()) + " INFO ";
+        return context.view().starts_with(expected);
+    };
+
+    LogContext context;
+    context.begin(__FILE__, __FUNCTION__, __LINE__, LogLevel::INFO, 0);
+    assert(startsWith(context, "19700101 00:00:00 000000"));
+    context.end();
+
+    // 秒数不变时只更新微秒
+    context.begin(__FILE__, __FUNCTION__, __LINE__, LogLevel::INFO, 1000 * 1000 + 5);
+    assert(startsWith(context, "19700101 00:00:01 000005"));
+    context.end();
+    context.begin(__FILE__, __FUNCTION__, __LINE__, LogLevel::INFO, 1000 * 1000 + 999999);
+    assert(startsWith(context, "19700101 00:00:01 999999"));
+    context.end();
+    context.begin(__FILE__, __FUNCTION__, __LINE__, LogLevel::INFO, 86400LL * 1000 * 1000 + 61 * 1000 * 1000 + 120);
+    assert(startsWith(context, "19700102 00:01:01 000120"));
+    context.end();
+
+    // 使用 EventLoop 缓存的时钟
+    LogContext::setThreadClock(1234567);
+    context.begin(__FILE__, __FUNCTION__, __LINE__, LogLevel::INFO);
+    assert(context.timestamp_ != 1234567);
+    context.end();
+    Logger::setUseLoopClock(true);
+    context.begin(__FILE__, __FUNCTION__, __LINE__, LogLevel::INFO);
+    assert(context.timestamp_ == 1234567);
+    assert(startsWith(context, "19700101 00:00:01 234567"));
+    context.end();
+    Logger::setUseLoopClock(false);
+    LogContext::setThreadClock(0);
+
+    std::cout << "test_LogTime pass." << std::endl;
+}
+
+void test_ThreadLogId()
+{
+    std::string mainId = std::to_string(CurrentThread::tid());
+    assert(CurrentThread::logId() == mainId);
+    assert(CurrentThread::tid() == static_cast<int>(::gettid()));
+
+    std::string threadId;
+    std::string line;
+    Thread thread("log-thread", [&threadId, &line]() {
+        threadId = std::to_string(CurrentThread::tid());
+        LogContext context;
+        context.begin(__FILE__, __FUNCTION__, __LINE__, LogLevel::WARN);
+        line = context.view();
+        context.end();
+    });
+    thread.start();
+    thread.join();
+
+    assert(threadId != mainId);
+    assert(line.find(" " + threadId + "/log-thread WARN ") != std::string::npos);
+
+    std::cout << "test_ThreadLogId pass." << std::endl;
+}
+
+int g_evaluated = 0;
+
+int evaluate()
+{
+    return ++g_evaluated;
+}
+
+void test_LogLevel()
+{
+    LogLevel saved = Logger::logLevel();
+    Logger::setLogLevel(LogLevel::WARN);
+
+    // 被过滤的日志语句不会求值参数
+    LOG_DEBUG << "disabled " << evaluate();
+    LOG_INFO << "disabled " << evaluate();
+    assert(g_evaluated == 0);
+
+    // 宏展开后不会吞掉外层的 else
+    bool elseTaken = false;
+    if (g_evaluated != 0)
+        LOG_INFO << "unreachable";
+    else
+        elseTaken = true;
+    assert(elseTaken);
+
+    // 添加级别更低的 LogHandler 时随之调低
+    Logger logger("level test");
+    logger.addHandler(std::make_shared<ConsoleHandler>("level test console", LogLevel::DEBUG));
+    assert(Logger::logLevel() == LogLevel::DEBUG);
+    logger.addHandler(std::make_shared<ConsoleHandler>("level test error console", LogLevel::ERROR));
+    assert(Logger::logLevel() == LogLevel::DEBUG);
+
+    Logger::setLogLevel(saved);
+    std::cout << "test_LogLevel pass." << std::endl;
+}
+
+// 日志文件名精确到分钟，测试跨过分钟边界时会滚动出多个文件，按文件名（即创建时间）排序后读取
+std::vector<std::filesystem::path> sortedLogFiles()
+{
+    std::vector<std::filesystem::path> files;
+    for (const auto &entry : std::filesystem::directory_iterator("."))
+    {
+        files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+void test_AsyncLoggingThreads()
+{
+    // 日志文件写在当前目录下，切换到临时目录中进行测试
+    char dir[] = "/tmp/stnl_logger_test_XXXXXX";
+    char *created = mkdtemp(dir);
+    assert(created != nullptr);
+    std::filesystem::path oldPath = std::filesystem::current_path();
+    std::filesystem::current_path(dir);
+
+    const int threadNums = 4;
+    const int linesPerThread = 20000;
+    {
+        // 较小的线程缓冲区，覆盖环形缓冲区回绕以及写满后等待后端线程的情况
+        std::shared_ptr<AsyncLogging> asyncLogger = std::make_shared<AsyncLogging>(".", LogLevel::INFO, 64 * 1024 * 1024, 1, 100, 16 * 1024);
+        asyncLogger->start();
+        Logger::instance().setAsyncLogger(asyncLogger);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadNums; ++t)
+        {
+            threads.emplace_back([t]() {
+                for (int i = 0; i < linesPerThread; ++i)
+                {
+                    LOG_INFO << "async-test " << t << ' ' << i;
+                }
+            });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        Logger::instance().setAsyncLogger(nullptr);
+        asyncLogger->stop();
+    }
+
+    // 每个线程的日志都完整写出，且保持该线程内的先后顺序
+    std::vector<int> nextSeq(threadNums, 0);
+    for (const auto &path : sortedLogFiles())
+    {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            size_t pos = line.find("async-test ");
+            if (pos == std::string::npos)
+            {
+                continue;
+            }
+            int t = 0;
+            int seq = 0;
+            int parsed = sscanf(line.c_str() + pos, "async-test %d %d", &t, &seq);
+            assert(parsed == 2);
+            assert(t >= 0 && t < threadNums);
+            assert(seq == nextSeq[t]);
+            ++nextSeq[t];
+        }
+    }
+    for (int t = 0; t < threadNums; ++t)
+    {
+        assert(nextSeq[t] == linesPerThread);
+    }
+
+    std::filesystem::current_path(oldPath);
+    std::filesystem::remove_all(dir);
+    std::cout << "test_AsyncLoggingThreads pass." << std::endl;
+}
+
+/**
+ * 统计临时目录下所有日志文件中包含 marker 的行数
+ */
+int countLogLines(const char *marker)
+{
+    int count = 0;
+    for (const auto &entry : std::filesystem::directory_iterator("."))
+    {
+        std::ifstream in(entry.path());
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (line.find(marker) != std::string::npos)
+            {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+void test_OverflowPolicy()
+{
+    char dir[] = "/tmp/stnl_logger_test_XXXXXX";
+    char *created = mkdtemp(dir);
+    assert(created != nullptr);
+    std::filesystem::path oldPath = std::filesystem::current_path();
+    std::filesystem::current_path(dir);
+
+    const int lines = 20000;
+    std::string padding(200, 'p');
+
+    // DropNewest：写出的日志与丢弃的日志之和等于总数
+    uint64_t dropped = 0;
+    {
+        std::shared_ptr<AsyncLogging> asyncLogger = std::make_shared<AsyncLogging>(".", LogLevel::INFO, 64 * 1024 * 1024, 1, 100, 4096);
+        asyncLogger->setOverflowPolicy(AsyncLogging::OverflowPolicy::DropNewest);
+        asyncLogger->start();
+        Logger::instance().setAsyncLogger(asyncLogger);
+        for (int i = 0; i < lines; ++i)
+        {
+            LOG_INFO << "drop-newest " << i << padding;
+        }
+        Logger::instance().setAsyncLogger(nullptr);
+        asyncLogger->stop();
+        dropped = asyncLogger->droppedLines();
+        assert(dropped == asyncLogger->droppedLines(LogLevel::INFO));
+    }
+    assert(countLogLines("drop-newest ") + static_cast<int>(dropped) == lines);
+    if (dropped > 0)
+    {
+        assert(countLogLines("AsyncLogging dropped ") > 0);
+    }
+
+    // DropByLevel：WARN 及以上的日志全部写出
+    {
+        std::shared_ptr<AsyncLogging> asyncLogger = std::make_shared<AsyncLogging>(".", LogLevel::INFO, 64 * 1024 * 1024, 1, 100, 4096);
+        asyncLogger->setOverflowPolicy(AsyncLogging::OverflowPolicy::DropByLevel, LogLevel::WARN);
+        asyncLogger->start();
+        Logger::instance().setAsyncLogger(asyncLogger);
+        for (int i = 0; i < lines; ++i)
+        {
+            LOG_INFO << "drop-by-level-info " << i << padding;
+            if (i % 10 == 0)
+            {
+                LOG_WARN << "drop-by-level-warn " << i << padding;
+            }
+        }
+        Logger::instance().setAsyncLogger(nullptr);
+        asyncLogger->stop();
+        dropped = asyncLogger->droppedLines(LogLevel::INFO);
+        assert(asyncLogger->droppedLines(LogLevel::WARN) == 0);
+    }
+    assert(countLogLines("drop-by-level-warn ") == lines / 10);
+    assert(countLogLines("drop-by-level-info ") + static_cast<int>(dropped) == lines);
+
+    std::filesystem::current_path(oldPath);
+    std::filesystem::remove_all(dir);
+    std::cout << "test_OverflowPolicy pass." << std::endl;
+}
+
+void test_LargeRecords()
+{
+    char dir[] = "/tmp/stnl_logger_test_XXXXXX";
+    char *created = mkdtemp(dir);
+    assert(created != nullptr);
+    std::filesystem::path oldPath = std::filesystem::current_path();
+    std::filesystem::current_path(dir);
+
+    // 超过线程缓冲区、超过后端 Buffer（AsyncBufferSize）的日志消息都完整写出，并保持先后顺序
+    std::string medium(100 * 1000, 'm');
+    std::string huge(AsyncBufferSize + 1000, 'h');
+    {
+        std::shared_ptr<AsyncLogging> asyncLogger = std::make_shared<AsyncLogging>(".", LogLevel::INFO, 64 * 1024 * 1024, 1, 100, 16 * 1024);
+        asyncLogger->start();
+        Logger::instance().setAsyncLogger(asyncLogger);
+        for (int i = 0; i < 10; ++i)
+        {
+            LOG_INFO << "large-test " << i << " small";
+            LOG_INFO << "large-test " << i << " medium " << medium;
+            LOG_INFO << "large-test " << i << " huge " << huge;
+        }
+        Logger::instance().setAsyncLogger(nullptr);
+        asyncLogger->stop();
+        assert(asyncLogger->droppedLines() == 0);
+    }
+
+    int next = 0;
+    for (const auto &path : sortedLogFiles())
+    {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            size_t pos = line.find("large-test ");
+            if (pos == std::string::npos)
+            {
+                continue;
+            }
+            const char *kinds[] = {"small", "medium", "huge"};
+            std::string expected = "large-test " + std::to_string(next / 3) + " " + kinds[next % 3];
+            assert(line.compare(pos, expected.size(), expected) == 0);
+            if (next % 3 == 1)
+            {
+                assert(line.size() == pos + expected.size() + 1 + medium.size());
+            }
+            else if (next % 3 == 2)
+            {
+                assert(line.size() == pos + expected.size() + 1 + huge.size());
+            }
+            ++next;
+        }
+    }
+    assert(next == 30);
+
+    std::filesystem::current_path(oldPath);
+    std::filesystem::remove_all(dir);
+    std::cout << "test_LargeRecords pass." << std::endl;
+}
+
+void test_LogFileType()
+{
+    char dir[] = "/tmp/stnl_logger_test_XXXXXX";
+    char *created = mkdtemp(dir);
+    assert(created != nullptr);
+    std::filesystem::path oldPath = std::filesystem::current_path();
+    std::filesystem::current_path(dir);
+
+    // 小块数据与超过内部缓冲区的大块数据交替写入，并且追加到已有文件的末尾
+    std::string expected = "existing\n";
+    {
+        std::ofstream out("direct.log");
+        out << expected;
+    }
+    {
+        DirectLogFile file("direct.log");
+        std::string large(DirectLogFile::BufferSize + 123, 'L');
+        for (int i = 0; i < 100; ++i)
+        {
+            std::string small = "line " + std::to_string(i) + "\n";
+            file.append(small.data(), static_cast<int>(small.size()));
+            expected += small;
+            if (i % 10 == 0)
+            {
+                file.append(large.data(), static_cast<int>(large.size()));
+                expected += large;
+            }
+        }
+        assert(file.writtenBytes() == static_cast<off_t>(expected.size() - 9));
+    }
+    {
+        std::ifstream in("direct.log");
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        assert(content == expected);
+    }
+    std::filesystem::remove("direct.log");
+
+    // 两个 DirectLogFile 写同一个文件，交替写出时不会覆盖对方的数据
+    {
+        DirectLogFile first("shared.log");
+        DirectLogFile second("shared.log");
+        std::string large(DirectLogFile::BufferSize, 'S');
+        for (int i = 0; i < 10; ++i)
+        {
+            std::string line = "first " + std::to_string(i) + "\n";
+            first.append(line.data(), static_cast<int>(line.size()));
+            line = "second " + std::to_string(i) + "\n";
+            second.append(line.data(), static_cast<int>(line.size()));
+            second.flush();
+            first.flush();
+        }
+        first.append(large.data(), static_cast<int>(large.size()));
+        second.append(large.data(), static_cast<int>(large.size()));
+    }
+    {
+        assert(std::filesystem::file_size("shared.log") == 10 * 8 + 10 * 9 + 2 * DirectLogFile::BufferSize);
+        std::ifstream in("shared.log");
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        for (int i = 0; i < 10; ++i)
+        {
+            assert(content.find("first " + std::to_string(i) + "\n") != std::string::npos);
+            assert(content.find("second " + std::to_string(i) + "\n") != std::string::npos);
+        }
+    }
+    std::filesystem::remove("shared.log");
+
+    // MappedLogFile：跨越多个窗口、超过预分配大小的写入；重新打开崩溃后留下的文件（有效数据之后是预分配的 0）
+    expected = "before crash\n";
+    {
+        std::ofstream out("mapped.log");
+        out << expected;
+    }
+    std::filesystem::resize_file("mapped.log", 64 * 1024);
+    {
+        MappedLogFile file("mapped.log", 64 * 1024, 0);
+        std::string large(MappedLogFile::WindowSize + 4567, 'M');
+        for (int i = 0; i < 3; ++i)
+        {
+            std::string small = "line " + std::to_string(i) + "\n";
+            file.append(small.data(), static_cast<int>(small.size()));
+            file.append(large.data(), static_cast<int>(large.size()));
+            expected += small + large;
+            file.flush();
+        }
+        assert(file.writtenBytes() == static_cast<off_t>(expected.size() - 13));
+    }
+    {
+        assert(std::filesystem::file_size("mapped.log") == expected.size());
+        std::ifstream in("mapped.log");
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        assert(content == expected);
+    }
+    std::filesystem::remove("mapped.log");
+
+    // 预分配的 0 远大于有效数据时，有效数据的末尾恰好在块边界上、块中间，或者没有数据
+    for (size_t dataSize : {size_t(0), size_t(1), size_t(4096), size_t(2 * 4096), size_t(3 * 4096 + 123)})
+    {
+        std::string data;
+        for (size_t i = 0; i < dataSize; ++i)
+        {
+            data.push_back(static_cast<char>('a' + i % 26));
+        }
+        {
+            std::ofstream out("crashed.log");
+            out << data;
+        }
+        std::filesystem::resize_file("crashed.log", 64 * 1024 * 1024);
+        {
+            MappedLogFile file("crashed.log", 4096, 0);
+            file.append("after\n", 6);
+        }
+        std::ifstream in("crashed.log");
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        assert(content == data + "after\n");
+    }
+    std::filesystem::remove("crashed.log");
+
+    // AsyncLogging 后端使用 DirectLogFile、MappedLogFile
+    for (LogFileType fileType : {LogFileType::Direct, LogFileType::Mmap})
+    {
+        std::filesystem::create_directory("type");
+        std::filesystem::current_path("type");
+        {
+            // 较小的滚动大小，同一秒内滚动会重新打开同一个文件
+            std::shared_ptr<AsyncLogging> asyncLogger = std::make_shared<AsyncLogging>(".", LogLevel::INFO, 64 * 1024, 1);
+            asyncLogger->setLogFileType(fileType);
+            asyncLogger->start();
+            Logger::instance().setAsyncLogger(asyncLogger);
+            for (int i = 0; i < 10000; ++i)
+            {
+                LOG_INFO << "file-type-test " << i;
+                if (i % 1000 == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                }
+            }
+            Logger::instance().setAsyncLogger(nullptr);
+            asyncLogger->stop();
+        }
+        int next = 0;
+        for (const auto &path : sortedLogFiles())
+        {
+            std::ifstream in(path);
+            std::string line;
+            while (std::getline(in, line))
+            {
+                assert(line.find('\0') == std::string::npos);
+                size_t pos = line.find("file-type-test ");
+                if (pos != std::string::npos)
+                {
+                    assert(line.substr(pos) == "file-type-test " + std::to_string(next));
+                    ++next;
+                }
+            }
+        }
+        assert(next == 10000);
+        std::filesystem::current_path("..");
+        std::filesystem::remove_all("type");
+    }
+
+    std::filesystem::current_path(oldPath);
+    std::filesystem::remove_all(dir);
+    std::cout << "test_LogFileType pass." << std::endl;
+}
+
+enum class BinaryTestEnum : uint8_t
+{
+    First = 1,
+    Second = 2,
+};
+
+void test_BinaryLogging()
+{
+    char dir[] = "/tmp/stnl_logger_test_XXXXXX";
+    char *created = mkdtemp(dir);
+    assert(created != nullptr);
+    std::filesystem::path oldPath = std::filesystem::current_path();
+    std::filesystem::current_path(dir);
+
+    {
+        std::shared_ptr<AsyncLogging> asyncLogger = std::make_shared<AsyncLogging>(".", LogLevel::INFO, 64 * 1024 * 1024, 1);
+        asyncLogger->start();
+        Logger::instance().setAsyncLogger(asyncLogger);
+
+        std::string str("str");
+        for (int i = 0; i < 1000; ++i)
+        {
+            LOG_BINARY_INFO("binary-test {} {} {} {} {} {}", i, -7L, 1.5, str, std::string_view("view"), "literal");
+            LOG_INFO << "text-test " << i;
+        }
+        LOG_BINARY_WARN("binary-test enum {} {}", BinaryTestEnum::Second, LogLevel::ERROR);
+        LOG_BINARY_WARN("binary-test no args");
+        LOG_BINARY_WARN("binary-test extra", 1, 'c');
+        LOG_BINARY_DEBUG("binary-test filtered {}", 0);
+
+        Logger::instance().setAsyncLogger(nullptr);
+        asyncLogger->stop();
+    }
+
+    int binaryLines = 0;
+    int textLines = 0;
+    bool enumArgs = false;
+    bool noArgs = false;
+    bool extraArgs = false;
+    for (const auto &path : sortedLogFiles())
+    {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            assert(line.find("filtered") == std::string::npos);
+            char expected[128];
+            snprintf(expected, sizeof(expected), "| binary-test %d -7 1.5 str view literal", binaryLines);
+            if (line.find(expected) != std::string::npos)
+            {
+                // 线程标识是写日志的线程，而不是格式化日志的后端线程
+                assert(line.find(" " + std::string(CurrentThread::logId()) + " INFO logger_test.cpp test_BinaryLogging ") != std::string::npos);
+                ++binaryLines;
+            }
+            else if (line.find("| text-test ") != std::string::npos)
+            {
+                ++textLines;
+            }
+            else if (line.find("WARN logger_test.cpp test_BinaryLogging") != std::string::npos)
+            {
+                enumArgs |= line.ends_with("| binary-test enum 2 4");
+                noArgs |= line.ends_with("| binary-test no args");
+                extraArgs |= line.ends_with("| binary-test extra 1 c");
+            }
+        }
+    }
+    assert(binaryLines == 1000);
+    assert(textLines == 1000);
+    assert(enumArgs && noArgs && extraArgs);
+
+    std::filesystem::current_path(oldPath);
+    std::filesystem::remove_all(dir);
+
+    // 没有设置 AsyncLogging 时在当前线程格式化
+    LOG_BINARY_WARN("binary-test without AsyncLogging {} {} {}", 1, "ok", BinaryTestEnum::Second);
+
+    std::cout << "test_BinaryLogging pass." << std::endl;
+}
+
 int main()
 {
+    test_LogContext();
+    test_LogTime();
+    test_ThreadLogId();
+    test_LogLevel();
+    test_AsyncLoggingThreads();
+    test_BinaryLogging();
+    test_OverflowPolicy();
+    test_LargeRecords();
+    test_LogFileType();
     test_ConsoleLogger();
 }
\ No newline at end of file